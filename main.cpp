@@ -1,128 +1,62 @@
 
 #include "util/graphs.hpp"
 #include "util/seq.hpp"
+#include "util/timer.hpp"
+#include "util/generate.hpp"
+#include "util/external.hpp"
 #include "solv/options.hpp"
 #include "solv/caterpillar.hpp"
+#include "solv/server.hpp"
+#include "solv/cache.hpp"
+#include "solv/search.hpp"
 #include "math.h"
-#include <cstdlib> // for std::rand()
 #include <unistd.h> // for getpid
-#include <algorithm> // for sort()
+#include <memory> // for unique_ptr
 
 void usage(const char* progname, std::ostream& o){
   o << "usage: " << progname << " ftree <file to read> [more opts]\t- read tree from file" << std::endl;
   o << "       " << progname << " scat <file to read> [more opts]\t- read sequence from file" << std::endl;
-  o << "       " << progname << " rtree <#vertices> [more opts]\t- create random tree"<< std::endl;
+  o << "       " << progname << " rtree <#vertices> [more opts]\t- create random recursive tree"<< std::endl;
+  o << "       " << progname << " utree <#vertices> [more opts]\t- create uniformly random tree"<< std::endl;
   o << "       " << progname << " rcat <#vertices> [more opts]\t- create random caterpillar"<< std::endl;
   o << "       " << progname << " rcats <#vertices> [more opts]\t- create random sparse caterpillar"<< std::endl;
   o << "       " << progname << " rscat <#vertices> <avg multiplicity> [more opts]\t- create random sequence & assume it's a caterpillar"<< std::endl;
+  o << "       " << progname << " gen <utree|rtree|rcat|rcats> <#vertices> <file> [seed <#>]\t- write a random tree to file (binary iff it ends in .bin)"<< std::endl;
+  o << "       " << progname << " xseq <file.bin> <sequence file> [scratch <file>]\t- write the status sequence of a binary tree file without loading the tree (keeping the counters in the scratch file instead of memory)"<< std::endl;
+  o << "       " << progname << " serve <socket|-> [binary] [threads <#>] [max_vertices <#>] [all]\t- answer sequences on a Unix socket or stdin/stdout (line-based or, with binary, length-prefixed) with caterpillar encodings (requests with more than max_vertices vertices, default 65536, are rejected)"<< std::endl;
+  o << "opts:  seed <#>\t\t- seed for the random generators (default: changes every run, printed for replay)" << std::endl;
+  o << "       time <text|csv>\t- print the time spent in each phase as table or CSV" << std::endl;
+  o << "       all\t\t- compute all configurations of the caterpillar table instead of stopping at the first caterpillar" << std::endl;
+  o << "       cache <file>\t- look up and remember reconstructions in a persistent cache (created if missing)" << std::endl;
+  o << "       checkpoint <file>\t- journal the caterpillar table to file and resume from it after a crash" << std::endl;
+  o << "       budget <#>\t- give up the search for a tree that is not a caterpillar after this many nodes (default 2^26)" << std::endl;
+  o << "       threads <#>\t- number of threads of this search (default: all cores)" << std::endl;
+  o << "       perf\t\t- also count cycles, instructions, cache- and branch-misses of each phase (implies time)" << std::endl;
   exit(1);
 }
 
-status::tree* get_random_tree(const size_t num_vertices){
-  status::vertex* vertex_nr[num_vertices];
-  status::vertex* root = new status::vertex();
-  status::tree* t = new status::tree(root);
-
-  std::srand(time(NULL) * getpid());
-
-  vertex_nr[0] = root;
-  for(uint i = 1; i < num_vertices; ++i)
-    vertex_nr[i] = t->add_vertex(vertex_nr[std::rand() % i]);
-  
-  return t;
-}
-
-
-#define percentage_backbone 30
-status::tree* get_random_caterpillar(const size_t num_vertices){
-  status::vertex* vertex_nr[num_vertices];
-  status::vertex* root = new status::vertex();
-  status::tree* t = new status::tree(root);
-
-  std::srand(time(NULL) * getpid());
-
-  // create backbone
-  size_t num_backbone = uint(num_vertices*percentage_backbone/100) + (std::rand() % uint(num_vertices*(100-percentage_backbone)/100));
-  std::cout << "selected "<<num_backbone<<" vertices for backbone" << std::endl;
-  vertex_nr[0] = root;
-  for(uint i = 1; i < num_backbone; ++i)
-    vertex_nr[i] = t->add_vertex(vertex_nr[i-1]);
-
-  // create leaves
-  for(uint i = num_backbone; i < num_vertices; ++i)
-    vertex_nr[i] = t->add_vertex(vertex_nr[std::rand() % num_backbone]);
-  
-  return t;
-}
-
-// get a random caterpillar whose backbone vertices have between 0 and 1 leaves
-status::tree* get_random_sparse_caterpillar(const size_t num_vertices){
-  status::vertex* vertex_nr[num_vertices];
-  status::vertex* root = new status::vertex();
-  status::tree* t = new status::tree(root);
-
-  std::srand(time(NULL) * getpid());
-
-  // create backbone using at least half the vertices
-  size_t num_backbone = uint((num_vertices+1)/2) + (std::rand() % uint(num_vertices/3));
-  std::cout << "selected "<<num_backbone<<" vertices for backbone" << std::endl;
-  vertex_nr[0] = root;
-  for(uint i = 1; i < num_backbone; ++i)
-    vertex_nr[i] = t->add_vertex(vertex_nr[i-1]);
-  // shuffle backbone vertices
-  std::random_shuffle(&vertex_nr[0], &vertex_nr[num_backbone]);
-
-  // give one leaf to each of the first backbone vertices (since leaves < n/2, some bb vertices don't get leaves)
-  for(uint i = num_backbone; i < num_vertices; ++i)
-    vertex_nr[i] = t->add_vertex(vertex_nr[i - num_backbone]);
-  
-  return t;
-}
-
-// get a random sequence of given length and average multiplicity
-status::sequence_t get_random_sequence(const uint num_vertices, const double avg_multi){
-  std::srand(time(NULL) * getpid());
-  // create a caterpillar of num_vertices vertices, compute its status sequence
-  // and change stati into existing stati until the avg multiplicity is reached
-  status::tree* t = get_random_caterpillar(num_vertices);
-  status::sequence_t s(compute_stati(*t));
-  delete t;
-
-  // compute center status
-  status::sequence_t::iterator center = s.begin();
-  for(status::sequence_t::iterator i = s.begin(); i != s.end(); ++i)
-    if(i->first < center->first) center = i;
-
-  while(num_vertices < avg_multi * s.size()){
-    // get two coordinates to merge
-    const uint x(std::rand() % s.size());
-    const uint y(std::rand() % s.size());
-    if(x == y) continue;
-    // transfer all occurances of the x'th status to the y'th status
-    status::sequence_t::iterator from = s.begin();
-    status::sequence_t::iterator to = s.begin();
-    for(uint i = 0; i < x; ++i) ++from;
-    for(uint i = 0; i < y; ++i) ++to;
-    // don't touch the center!
-    if((from == center) || (to == center)) continue;
-    //std::cout << "merging "<<from->first<<" and "<<to->first<<std::endl;
-    to->second += from->second;
-    s.erase(from);
-    //std::cout << "got "<<s.size()<<" stati, avg multi is "<<(double)num_vertices/s.size()<<std::endl;
-  }
-
-  return s;
-}
-
-
-
 const std::pair<string, int> _requires_params[] = {
   { "ftree", 1 },
   { "scat", 1 },
   { "rtree",  1 },
+  { "utree",  1 },
+  { "gen",  3 },
+  { "xseq", 2 },
+  { "serve", 1 },
+  { "max_vertices", 1 },
+  { "binary", 0 },
+  { "threads", 1 },
+  { "scratch", 1 },
   { "rcat",  1 },
   { "rcats",  1 },
   { "rscat", 2},
+  { "seed", 1},
+  { "time", 1},
+  { "perf", 0},
+  { "all", 0},
+  { "cache", 1},
+  { "checkpoint", 1},
+  { "budget", 1},
 };
 // global arguments with their parameters
 std::map<string, std::vector<string> > arguments;
@@ -143,6 +77,15 @@ void parse_args(int argc, char** argv, status::solv_options& opts){
       params[i] = argv[arg_ptr++];
     arguments.insert(make_pair(arg, params));
   }
+  if(arguments.find("all") != arguments.end()) opts.first_solution = false;
+}
+
+// print the time spent in each phase if it was asked for (with "time" or "perf")
+void print_timing_report(){
+  if(!status::timing_enabled()) return;
+  const bool csv((arguments.find("time") != arguments.end()) && (arguments["time"][0] == "csv"));
+  if(!csv) std::cout << "time per phase:" << std::endl;
+  status::print_timings(std::cout, csv);
 }
 
 int main(int argc, char** argv)
@@ -155,65 +98,157 @@ int main(int argc, char** argv)
 
   // parse the arguments, filling 'arguments'
   parse_args(argc, argv, opts);
+  std::unique_ptr<status::reconstruction_cache> cache;
+  if(arguments.find("cache") != arguments.end()){
+    cache.reset(new status::reconstruction_cache(arguments["cache"][0]));
+    opts.cache = cache.get();
+  }
+
+  if(arguments.find("serve") != arguments.end()){
+    // answer requests until the input ends or we are stopped, without writing any files
+    status::server_options server;
+    server.socket_path = arguments["serve"][0];
+    server.binary = (arguments.find("binary") != arguments.end());
+    if(arguments.find("threads") != arguments.end()) server.threads = atoi(arguments["threads"][0].c_str());
+    if(arguments.find("max_vertices") != arguments.end()) server.max_vertices = strtoul(arguments["max_vertices"][0].c_str(), NULL, 10);
+    server.solver = opts;
+    status::serve(server);
+    return 0;
+  }
 
-  if(arguments.find("rtree") != arguments.end()){
-    // create a random tree
-    t = get_random_tree(atoi(arguments["rtree"][0].c_str()));
-  } else if(arguments.find("rcat") != arguments.end()) {
-    // create a random caterpillar
-    t = get_random_caterpillar(atoi(arguments["rcat"][0].c_str()));
-    is_caterpillar = true;
-  } else if(arguments.find("rcats") != arguments.end()) {
-    // create a random sparse caterpillar
-    t = get_random_sparse_caterpillar(atoi(arguments["rcats"][0].c_str()));
-    is_caterpillar = true;
-  } else if(arguments.find("rscat") != arguments.end()) {
-    // create a random sparse caterpillar
-    s = get_random_sequence(atoi(arguments["rscat"][0].c_str()), atof(arguments["rscat"][1].c_str()));
-    is_caterpillar = true;
-  } else if(arguments.find("ftree") != arguments.end()) {
-    // create a graph from file
-    t = new status::tree();
-    t->read_from_file(arguments["ftree"][0]);
-    is_caterpillar = detect_caterpillar(*t);
-  } else if(arguments.find("scat") != arguments.end()) {
-    // create a graph from file
-    status::sequence_t s(status::read_sequence_from_file(arguments["scat"][0]));
-    std::cout << "status sequence: " << s << std::endl;
-  } else usage(argv[0], std::cerr);
+  // a journal belongs to one sequence, so it is not for the server
+  if(arguments.find("checkpoint") != arguments.end()) opts.checkpoint_file = arguments["checkpoint"][0];
+  if(arguments.find("budget") != arguments.end()) opts.search_budget = strtoull(arguments["budget"][0].c_str(), NULL, 10);
+  if(arguments.find("threads") != arguments.end()) opts.search_threads = atoi(arguments["threads"][0].c_str());
+
+  const bool perf(arguments.find("perf") != arguments.end());
+  if(perf || (arguments.find("time") != arguments.end())) status::enable_timing(perf);
+
+  // seed for the random generators
+  const uint64_t seed((arguments.find("seed") != arguments.end()) ? strtoull(arguments["seed"][0].c_str(), NULL, 10)
+                                                                   : status::mix64(time(NULL)) ^ getpid());
+
+  // the modes that only write a file
+  if(arguments.find("xseq") != arguments.end()){
+    // compute the sequence of a tree out of core
+    { status::phase_timer timer("external_stati");
+      const std::string scratch((arguments.find("scratch") != arguments.end()) ? arguments["scratch"][0] : "");
+      status::external_stati(arguments["xseq"][0], arguments["xseq"][1], scratch); }
+    std::cout << "wrote the status sequence to " << arguments["xseq"][1] << std::endl;
+    print_timing_report();
+    return 0;
+  }
+  if(arguments.find("gen") != arguments.end()){
+    std::cout << "seed: " << seed << std::endl;
+    // write a random tree to disk (recursive trees and caterpillars are streamed)
+    const std::string kind(arguments["gen"][0]);
+    const size_t n(strtoull(arguments["gen"][1].c_str(), NULL, 10));
+    const std::string filename(arguments["gen"][2]);
+    { status::phase_timer timer("generate");
+      if(kind == "rtree" || kind == "rcat"){
+        status::parent_writer w(filename, n, status::is_binary_tree_name(filename));
+        if(kind == "rtree") status::stream_random_recursive(n, seed, w); else status::stream_random_caterpillar(n, seed, w);
+      } else {
+        status::parent_array parent;
+        if(kind == "utree") status::random_uniform_parents(n, seed, parent);
+        else if(kind == "rcats") status::random_sparse_caterpillar_parents(n, seed, parent);
+        else usage(argv[0], std::cerr);
+        status::write_parents(parent, filename);
+      } }
+    std::cout << "wrote " << n << " vertices to " << filename << std::endl;
+    print_timing_report();
+    return 0;
+  }
+
+  // read or generate the input
+  { status::phase_timer timer("input");
+    if(arguments.find("ftree") == arguments.end() && arguments.find("scat") == arguments.end())
+      std::cout << "seed: " << seed << std::endl;
+    if(arguments.find("rtree") != arguments.end()){
+      // create a random tree
+      t = status::get_random_tree(atoi(arguments["rtree"][0].c_str()), seed);
+    } else if(arguments.find("utree") != arguments.end()){
+      // create a uniformly random tree
+      t = status::get_random_uniform_tree(atoi(arguments["utree"][0].c_str()), seed);
+    } else if(arguments.find("rcat") != arguments.end()) {
+      // create a random caterpillar
+      t = status::get_random_caterpillar(atoi(arguments["rcat"][0].c_str()), seed);
+      is_caterpillar = true;
+    } else if(arguments.find("rcats") != arguments.end()) {
+      // create a random sparse caterpillar
+      t = status::get_random_sparse_caterpillar(atoi(arguments["rcats"][0].c_str()), seed);
+      is_caterpillar = true;
+    } else if(arguments.find("rscat") != arguments.end()) {
+      // create a random sparse caterpillar
+      s = status::get_random_sequence(atoi(arguments["rscat"][0].c_str()), atof(arguments["rscat"][1].c_str()), seed);
+      is_caterpillar = true;
+    } else if(arguments.find("ftree") != arguments.end()) {
+      // create a graph from file
+      t = status::read_tree(arguments["ftree"][0]);
+      is_caterpillar = detect_caterpillar(*t);
+    } else if(arguments.find("scat") != arguments.end()) {
+      // create a graph from file
+      s = status::read_sequence_from_file(arguments["scat"][0]);
+      std::cout << "status sequence: " << s << std::endl;
+      is_caterpillar = true;
+    } else usage(argv[0], std::cerr);
+  }
 
   if(t){ // if we're given a tree, convert it to a sequence, while writing it down to .tree
     cout << "writing tree to .tmp for reference" << endl;
-    t->write_to_file(".tree");
+    { status::phase_timer timer("write_tree");
+      t->write_to_file(".tree"); }
 
-    std::cout << *t << endl;
+    { status::phase_timer timer("print_tree");
+      std::cout << *t << endl; }
     cout << "computing stati"<< endl;
-    const status::sequence_t s(status::compute_stati(*t));
+    vector<uint> stati(t->get_size());
+    { status::phase_timer timer("compute_stati");
+      status::compute_stati(*t, stati.data());
+      for(const uint x : stati) s[x]++; }
     // reroot t at its median
     cout << "computing median"<<endl;
-    status::vertex* median = status::compute_median(*t);
-    t->clear_data();
+    status::vertex* median;
+    { status::phase_timer timer("compute_median");
+      median = status::compute_median(*t, stati.data()); }
     cout << "rerooting tree at median" <<endl;
-    t->reroot(median);
+    { status::phase_timer timer("reroot");
+      t->reroot(median); }
 
-    std::cout << *t << endl;
+    { status::phase_timer timer("print_tree");
+      std::cout << *t << endl; }
   } 
 
   std::cout << "status sequence: " << s << std::endl;
   // write the status sequence to .sequence
-  status::write_sequence_to_file(s, ".sequence");
+  { status::phase_timer timer("write_sequence");
+    status::write_sequence_to_file(s, ".sequence"); }
 
+  status::sequence_verdict verdict(status::SEQUENCE_OK);
   if(is_caterpillar){
-    result = status::stati_to_caterpillar(s);
+    status::phase_timer timer("stati_to_caterpillar");
+    result = status::stati_to_caterpillar(s, opts, &verdict);
   } else {
     std::cout << "this is not a caterpillar..."<<std::endl;
     result = NULL;
   }
+  // search among all trees if there is no caterpillar (but the sequence passed the pre-filter)
+  if(!result && (verdict == status::SEQUENCE_OK)){
+    status::search_outcome outcome;
+    { status::phase_timer timer("stati_to_tree");
+      result = status::stati_to_tree(s, opts, &outcome, &verdict); }
+    std::cout << "searched "<<status::get_search_nodes()<<" nodes: "<<status::get_outcome_description(outcome)<<std::endl;
+  }
   if(result){
     std::cout << "reconstructed:" << std::endl << *result << std::endl << "largest list: "<<status::get_set_list_max()<<std::endl;
-    status::sequence_t check(status::compute_stati(*result));
+    status::sequence_t check;
+    { status::phase_timer timer("recheck");
+      check = status::compute_stati(*result); }
     std::cout << "recheck stati "<<check<<": "<<(status::equal(s, check) ? "match! Good job :)" : "!!! NO MATCH !!!")<<std::endl;
   } else {
+    if(verdict != status::SEQUENCE_OK) std::cout << "rejected the sequence: " << status::get_verdict_description(verdict) << std::endl;
     std::cout << "could not reconstruct the graph" << std::endl << "largest list: "<<status::get_set_list_max()<<std::endl;
   }
+
+  print_timing_report();
 }
@@ -0,0 +1,186 @@
+#include "cache.hpp"
+#include "../util/random.hpp"
+#include <algorithm>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CACHE_MAGIC 0x5354415443414348ULL
+#define CACHE_VERSION 1
+// the header gets a page of its own
+#define CACHE_HEADER_BYTES 4096
+// the number of slots of the index that a sequence may occupy, starting at its hash
+#define CACHE_PROBES 8
+
+namespace status {
+
+  struct cache_header {
+    uint64_t magic;
+    uint64_t version;
+    uint64_t num_slots;
+    uint64_t data_bytes;
+    // the number of bytes appended to the ring since the cache was created
+    uint64_t head;
+    uint64_t inserts;
+  };
+
+  // a slot of the index: the key of a sequence (0 = empty) and the logical offset of its entry in the ring
+  struct cache_slot {
+    uint64_t key;
+    uint64_t offset;
+  };
+
+  // an entry of the ring, followed by num_stati (status, multiplicity) pairs and length numbers of leaves
+  struct cache_entry {
+    uint64_t key;
+    uint64_t offset;
+    uint32_t num_stati;
+    uint32_t answer;
+    uint32_t length;
+    uint32_t unused;
+  };
+
+  static_assert(sizeof(pair<uint, uint>) == 2 * sizeof(uint32_t), "the pairs of a sequence are stored as they are");
+
+  inline size_t entry_bytes(const size_t num_stati, const size_t length){
+    return (sizeof(cache_entry) + (2 * num_stati + length) * sizeof(uint32_t) + 7) & ~(size_t)7;
+  }
+
+  // the sorted (status, multiplicity) pairs of the last sequence whose key was computed in this thread
+  thread_local vector<pair<uint, uint> > cache_pairs;
+
+  // compute the key of s and leave its sorted pairs in cache_pairs
+  uint64_t canonical_key(const sequence_t& s){
+    cache_pairs.assign(s.begin(), s.end());
+    sort(cache_pairs.begin(), cache_pairs.end());
+    uint64_t key(mix64(s.size()));
+    for(const auto& p : cache_pairs) key = mix64(key ^ (((uint64_t)p.first << 32) | p.second));
+    // 0 marks empty slots
+    return key ? key : 1;
+  }
+
+  reconstruction_cache::reconstruction_cache(const string filename, const size_t data_bytes):
+    fd(open(filename.c_str(), O_RDWR | O_CREAT, 0644)), mapped_bytes(0), header(NULL), slots(NULL), data(NULL)
+  {
+    if(fd < 0) FAIL("unable to open the cache "<<filename);
+    // whoever comes first creates the cache, the others wait for it
+    if(flock(fd, LOCK_EX)) FAIL("unable to lock the cache "<<filename);
+    struct stat st;
+    if(fstat(fd, &st)) FAIL("unable to stat the cache "<<filename);
+    cache_header h;
+    if(st.st_size == 0){
+      memset(&h, 0, sizeof(h));
+      h.magic = CACHE_MAGIC;
+      h.version = CACHE_VERSION;
+      // about one slot per 64 bytes of entries, a power of two so that probing can mask
+      h.num_slots = 1024;
+      while(h.num_slots * 64 < data_bytes) h.num_slots <<= 1;
+      h.data_bytes = max((size_t)4096, data_bytes & ~(size_t)7);
+      if(ftruncate(fd, CACHE_HEADER_BYTES + h.num_slots * sizeof(cache_slot) + h.data_bytes))
+        FAIL("unable to grow the cache "<<filename);
+      if(pwrite(fd, &h, sizeof(h), 0) != sizeof(h)) FAIL("unable to write the cache "<<filename);
+    } else if(pread(fd, &h, sizeof(h), 0) != sizeof(h)) FAIL("unable to read the cache "<<filename);
+    if((h.magic != CACHE_MAGIC) || (h.version != CACHE_VERSION)) FAIL(filename<<" is not a reconstruction cache");
+    mapped_bytes = CACHE_HEADER_BYTES + h.num_slots * sizeof(cache_slot) + h.data_bytes;
+    if(fstat(fd, &st) || ((size_t)st.st_size != mapped_bytes)) FAIL("the cache "<<filename<<" is truncated");
+    flock(fd, LOCK_UN);
+
+    void* const m(mmap(NULL, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    if(m == MAP_FAILED) FAIL("unable to map the cache "<<filename);
+    header = (cache_header*)m;
+    slots = (cache_slot*)((char*)m + CACHE_HEADER_BYTES);
+    data = (char*)(slots + h.num_slots);
+  }
+
+  reconstruction_cache::~reconstruction_cache(){
+    munmap(header, mapped_bytes);
+    close(fd);
+  }
+
+  cache_answer reconstruction_cache::lookup(const sequence_t& s, vector<uint>& leaves) const{
+    const uint64_t key(canonical_key(s));
+    const uint64_t mask(header->num_slots - 1);
+    const uint64_t ring(header->data_bytes);
+    const uint num_stati(s.size());
+    for(uint i = 0; i < CACHE_PROBES; ++i){
+      const cache_slot& slot(slots[(key + i) & mask]);
+      const uint64_t k(__atomic_load_n(&slot.key, __ATOMIC_ACQUIRE));
+      if(!k) return CACHE_MISS;
+      if(k != key) continue;
+      const uint64_t offset(__atomic_load_n(&slot.offset, __ATOMIC_ACQUIRE));
+      if(__atomic_load_n(&header->head, __ATOMIC_ACQUIRE) - offset > ring) continue;
+
+      // copy the entry and check that it's ours and that nobody overwrote it meanwhile
+      const char* const e(data + offset % ring);
+      cache_entry entry;
+      memcpy(&entry, e, sizeof(entry));
+      if((entry.key != key) || (entry.offset != offset) || (entry.num_stati != num_stati)) continue;
+      if((entry.length > ring) || (offset % ring + entry_bytes(num_stati, entry.length) > ring)) continue;
+      const uint32_t* const stored((const uint32_t*)(e + sizeof(cache_entry)));
+      if(memcmp(stored, cache_pairs.data(), num_stati * sizeof(pair<uint, uint>))) continue;
+      leaves.assign(stored + 2 * num_stati, stored + 2 * num_stati + entry.length);
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      if(__atomic_load_n(&header->head, __ATOMIC_RELAXED) - offset > ring) return CACHE_MISS;
+      return (cache_answer)entry.answer;
+    }
+    return CACHE_MISS;
+  }
+
+  void reconstruction_cache::insert(const sequence_t& s, const cache_answer answer, const uint* const leaves, const uint length){
+    assert(answer != CACHE_MISS);
+    const uint64_t key(canonical_key(s));
+    const uint64_t ring(header->data_bytes);
+    const size_t bytes(entry_bytes(s.size(), length));
+    // an entry that takes a good part of the ring would evict too much
+    if(bytes > ring / 4) return;
+
+    lock_guard<mutex> guard(write_lock);
+    if(flock(fd, LOCK_EX)) return;
+    // entries do not wrap around the end of the ring
+    uint64_t offset(header->head);
+    if(offset % ring + bytes > ring) offset += ring - offset % ring;
+    // evict what we are going to overwrite before writing it
+    __atomic_store_n(&header->head, offset + bytes, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    char* const e(data + offset % ring);
+    cache_entry entry;
+    entry.key = key;
+    entry.offset = offset;
+    entry.num_stati = s.size();
+    entry.answer = answer;
+    entry.length = length;
+    entry.unused = 0;
+    memcpy(e, &entry, sizeof(entry));
+    memcpy(e + sizeof(entry), cache_pairs.data(), cache_pairs.size() * sizeof(pair<uint, uint>));
+    if(length) memcpy(e + sizeof(entry) + cache_pairs.size() * sizeof(pair<uint, uint>), leaves, length * sizeof(uint32_t));
+
+    // take the slot of the same key, or else an empty one, or else one whose entry was evicted, or else the oldest
+    const uint64_t mask(header->num_slots - 1);
+    cache_slot* target(NULL);
+    cache_slot* evicted(NULL);
+    cache_slot* oldest(NULL);
+    for(uint i = 0; i < CACHE_PROBES; ++i){
+      cache_slot& slot(slots[(key + i) & mask]);
+      if((slot.key == key) || !slot.key){
+        target = &slot;
+        break;
+      }
+      if(!evicted && (offset - slot.offset > ring)) evicted = &slot;
+      if(!oldest || (slot.offset < oldest->offset)) oldest = &slot;
+    }
+    if(!target) target = evicted ? evicted : oldest;
+    // publish the entry; a reader seeing the new key with the old offset (or vice versa) finds a foreign entry and misses
+    __atomic_store_n(&target->offset, offset, __ATOMIC_RELEASE);
+    __atomic_store_n(&target->key, key, __ATOMIC_RELEASE);
+    __atomic_store_n(&header->inserts, header->inserts + 1, __ATOMIC_RELAXED);
+    flock(fd, LOCK_UN);
+  }
+
+  uint64_t reconstruction_cache::get_inserts() const { return __atomic_load_n(&header->inserts, __ATOMIC_RELAXED); }
+  uint64_t reconstruction_cache::get_capacity() const { return header->data_bytes; }
+
+};
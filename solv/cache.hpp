@@ -0,0 +1,53 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include "../util/defs.hpp"
+#include "../util/seq.hpp"
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+namespace status {
+
+  // what the cache knows about a sequence
+  enum cache_answer { CACHE_MISS, CACHE_CATERPILLAR, CACHE_NO_CATERPILLAR };
+
+  // a persistent cache of reconstructions in a file that is mapped into memory and shared by all processes using it
+  // the key of a sequence is a hash of its sorted (status, multiplicity) pairs; each entry stores these pairs (so that hash
+  // collisions are told apart) and the encoding of the caterpillar (see recognize_caterpillar) or that there is none
+  //
+  // the file consists of a header, a hash index of fixed size (open addressing with a short probe window) and a data region
+  // that is a ring of entries: entries are only ever appended, and once the ring is full, each new entry overwrites the
+  // oldest ones, evicting them; this bounds the size of the file
+  // readers take no locks: the header holds the total number of bytes ever appended (head), and an entry at (logical)
+  // offset o is alive iff head - o is at most the size of the ring; a writer advances head before it overwrites anything,
+  // so a reader that finds its entry still alive after copying it knows the copy is intact (like a seqlock)
+  // writers are serialized by flock (between processes) and a mutex (between threads)
+  class reconstruction_cache {
+    int fd;
+    size_t mapped_bytes;
+    struct cache_header* header;
+    struct cache_slot* slots;
+    char* data;
+    mutex write_lock;
+  public:
+    // open the cache in the given file, creating it with a ring of data_bytes bytes if it does not exist yet
+    // (an existing cache keeps the size it was created with)
+    reconstruction_cache(const string filename, const size_t data_bytes = 64 << 20);
+    ~reconstruction_cache();
+
+    // look up s, on a hit of a caterpillar its encoding is written to leaves
+    cache_answer lookup(const sequence_t& s, vector<uint>& leaves) const;
+    // store the answer for s (with the encoding of length length if answer is CACHE_CATERPILLAR)
+    void insert(const sequence_t& s, const cache_answer answer, const uint* const leaves = NULL, const uint length = 0);
+
+    // the number of entries ever inserted and the number of bytes of the ring
+    uint64_t get_inserts() const;
+    uint64_t get_capacity() const;
+  };
+
+};
+
+#endif
@@ -1,10 +1,36 @@
 #include "caterpillar.hpp"
+#include "checkpoint.hpp"
+#include <algorithm>
+#include <memory>
 
 namespace status{
 
-  unordered_map<cat_dynprog_input_pair, cat_dynprog_configs, input_pair_hasher> cat_DP_table;
-  bool cat_DP_table_initialized(false);
-  size_t largest_set_list(0);
+  // the state of the dynamic programming is kept per thread and reused (clearing a table keeps its buckets), so a thread
+  // that reconstructs many caterpillars does not start from scratch each time
+  thread_local cat_dynprog_table cat_DP_table;
+  thread_local size_t largest_set_list(0);
+  thread_local solv_options cat_options;
+
+  // the update that a level of the recursion applies to the configs returned by the level below
+  struct cat_pending_update {
+    pair<bool, bool> update_who;
+    pair<leaf_guess_t, leaf_guess_t> guess;
+    uint next_status;
+    uint bb_id, leaf_id;
+    bool mirrored;
+  };
+  // in first_solution mode, the updates that the levels above will apply to the configs of the current level (the
+  // innermost last), so we can tell right away whether a config completes to a caterpillar, which is then kept here
+  thread_local vector<cat_pending_update> cat_pending;
+  thread_local tree* cat_solution(NULL);
+  // the journal that new entries of the table go to (if any)
+  thread_local cat_checkpoint* cat_journal(NULL);
+  // the encoding of the caterpillar going into or coming out of the cache
+  thread_local vector<uint> cat_backbone, cat_leaves;
+  // the IDs of the stati of the sequence, the status of each ID and the multiplicity of each ID in the sequence
+  thread_local sequence_t cat_status_ids;
+  thread_local vector<uint> cat_id_stati;
+  thread_local dense_multiset cat_sequence_counts;
 
   inline bool operator==(const cat_dynprog_input& X, const cat_dynprog_input& Y){
     return (X.status == Y.status) && (X.subtree == Y.subtree) && (X.influx == Y.influx);
@@ -21,6 +47,19 @@ namespace status{
 
 
 
+  // order inputs by subtree, then influx, then status
+  inline bool mirror_less(const cat_dynprog_input& X, const cat_dynprog_input& Y){
+    if(X.subtree != Y.subtree) return X.subtree < Y.subtree;
+    if(X.influx != Y.influx) return X.influx < Y.influx;
+    return X.status < Y.status;
+  }
+  // a pair of inputs and its mirror image (first and second swapped) describe the same caterpillars, mirrored; only the
+  // pair whose first input is smaller goes to the table (pairs with an open end are not mirrored)
+  inline bool is_mirrored(const cat_dynprog_input_pair& inputs){
+    if((inputs.first == NO_INPUT) || (inputs.second == NO_INPUT)) return false;
+    return mirror_less(inputs.second, inputs.first);
+  }
+
   inline void mark_invalid(cat_dynprog_input& input){
     input = INVALID_INPUT;
   }
@@ -137,94 +176,36 @@ namespace status{
 
 
   // TODO: use (leaf stati <= exists vertex with n-2 status difference) to save guesses
-  // initialize the dynamic programming table
-  void caterpillar_dynprog_initialize(const sequence_t& stati_seq,
-                                      const list<uint>& stati_list,
-                                      const uint num_vertices)
+  // the entries of the dynamic programming table at the center: every partition of the vertices and influxes to the
+  // left and right side is possible; there are a lot of them and only few are ever asked for, so instead of putting
+  // them all into the table up front, we recognize them when they are asked for
+  bool is_center_input_pair(const cat_dynprog_input_pair& inputs,
+                            const uint center_status,
+                            const uint center_occurances,
+                            const uint num_vertices)
   {
-    DEBUG2(cout << "initializing dynprog table"<<endl);
-    // initialize the set list counter as well
-    largest_set_list = 0;
-    // get the center status
-    const uint center_status(stati_list.front());
-    // get occurances of the center
-    const uint center_occurances(stati_seq.at(center_status));
-    // get leaf status corresponding to the center
-    //const uint center_leaf_status(get_corresponding_leaf_status(center_status, num_vertices));
-    // create container to hold the table entries
-    cat_dynprog_config config;
-    // leave stati_used blank
-
-    // slightly hacky, please forgive me:
-    // we're counting 0 each time we use the center, so we put the right number here
-//    config.stati_used[center_status] = center_occurances;
-
-
-    // the input stati to be computed
-    cat_dynprog_input_pair inputs;
+    if((inputs.first.status != center_status) || (inputs.second.status != center_status)) return false;
     if(center_occurances == 1){
-      // the center is unique
-
-
-      // for each partition of the vertices to the left and right side (by symmetry of the caterpillar, we assume left < right)
-      for(uint subtree_left = 1; subtree_left <= (num_vertices + 1)/2; ++subtree_left){ 
-        // if the left subtree is 0, then the second input is fully determined, go create the DP-table entry
-        inputs.first.status = inputs.second.status = center_status;
-
-        const uint subtree_right(num_vertices - subtree_left + 1);
-        //const uint center_leaves((stati_seq.find(center_leaf_status) != stati_seq.end()) ? stati_seq.at(center_leaf_status) : 0);
-
-        inputs.first.subtree = subtree_left;
-        inputs.second.subtree = subtree_right;
-        // influx to the right must be at least subtree_left-1
-        DEBUG2(cout << "range for influx_right: "<<subtree_left-1<<"-"<<center_status-(subtree_right -1)<<endl);
-        // for each partition of influxes and subgraph sizes, compute respective inputs (the root is counted twice)
-        for(uint influx_right = subtree_left - 1; influx_right + (subtree_right - 1)<= center_status; ++influx_right){
-          const uint influx_left(center_status - influx_right);
-          inputs.second.influx = influx_right;
-          inputs.first.influx = influx_left;
-
-          // TODO: some of the inputs are still not sane (according to is_sane) - generate less!
-          config.inner_cat = new tree();
-//          vertex* root = config.inner_cat->add_vertex(NULL);
-//          config.docks = make_pair(root, root);
-
-
-
-          // finally, create a cat_DP_table entry with inputs and all possible status combinations on each side
-          cat_dynprog_configs& confs(cat_DP_table[inputs]);
-          confs.insert(config);
-          DEBUG2(cout << "guess: subtree_left="<<subtree_left<<" of "<<num_vertices<<" influx_left="<<influx_left<<"\t\tT"<<inputs<<"="<<confs<<" now"<<endl);
-        }
-      }
+      // the center is unique and counted on both sides (the table only has pairs with left <= right, see is_mirrored)
+      const uint subtree_left(inputs.first.subtree);
+      if((subtree_left == 0) || (subtree_left > (num_vertices + 1)/2)) return false;
+      if(inputs.second.subtree != num_vertices - subtree_left + 1) return false;
+      // influx to the right must be at least subtree_left-1, and the influxes add up to the center status
+      const uint influx_right(inputs.second.influx);
+      if((influx_right < subtree_left - 1) || (influx_right + (inputs.second.subtree - 1) > center_status)) return false;
+      return inputs.first.influx == center_status - influx_right;
     } else {
-      // the center is not unique
-      if(center_occurances > 2) FAIL("detected "<<center_occurances<<">2 center vertices");
-      if(num_vertices & 1) FAIL("2 centers and odd number of vertices, this is not right...");
-
+      // the center is not unique (the pre-filter made sure that there are 2 and that their number is even)
+      assert(center_occurances == 2);
+      assert(!(num_vertices & 1));
       // both sides get the same status and number of vertices by n - 2n_1 = s - s = n - 2n_2
-      inputs.first.status = inputs.second.status = center_status;
-      inputs.first.subtree = inputs.second.subtree = num_vertices>>1;
-
-      // for each reasonable partition of influxes and leaves, compute respective inputs
-      for(uint influx_left = 2*inputs.second.subtree - 1; influx_left + inputs.first.subtree - 1 <= center_status; ++influx_left){
-        inputs.first.influx = influx_left;
-        // use formulars f_2 + g_2 + l_2 = s  and  f_1 = g_2 +  l_2 + n_2
-        inputs.second.influx = center_status + inputs.second.subtree - influx_left;
-
-        config.inner_cat = new tree();
-//        vertex* root1 = config.inner_cat->add_vertex(NULL);
-//        vertex* root2 = config.inner_cat->add_vertex(root1);
-//        config.docks = make_pair(root1, root2);
-
-        // finally, create a cat_DP_table entry with inputs and all possible status combinations on each side
-        cat_dynprog_configs& confs(cat_DP_table[inputs]);
-        confs.insert(config);
-        DEBUG2(cout << "guess: influx_left="<<influx_left<<"\t\tT"<<inputs<<"="<<confs<<" now"<<endl);
-      }
+      const uint half(num_vertices >> 1);
+      if((inputs.first.subtree != half) || (inputs.second.subtree != half)) return false;
+      const uint influx_left(inputs.first.influx);
+      if((influx_left < 2 * half - 1) || (influx_left + half - 1 > center_status)) return false;
+      // use formulars f_2 + g_2 + l_2 = s  and  f_1 = g_2 +  l_2 + n_2
+      return inputs.second.influx == center_status + half - influx_left;
     }
-    // finally mark table as initialized
-    cat_DP_table_initialized = true;
   }
 
   // update one half of a config given by a recursive call of the dynamic programming
@@ -242,64 +223,137 @@ namespace status{
     DEBUG1(cout << "yielded "<<endl<< *t<<endl);
   }
 
-  // update the attachment with a given list of consumed stati
-  bool update_attachments(sequence_t& stati_used,
-                          const sequence_t& stati_seq,
-                          const uint bb_status,
-                          const uint leaf_status,
-                          const uint center_status,
+  // update the attachment with a given list of consumed stati, given by their IDs (see get_status_id)
+  bool update_attachments(dense_multiset& stati_used,
+                          const uint bb_id,
+                          const uint leaf_id,
                           const uint leaves)
   {
     // add the backbone status to the attachment if we guessed so (otherwise it will be 0)
     // if we used more stati then we have, return failure
     if(leaves) {
-      stati_used[leaf_status] += leaves;
-      if(stati_seq.at(leaf_status) < stati_used.at(leaf_status)) return false;
+      assert(leaf_id != UINT_MAX);
+      stati_used.add(leaf_id, leaves);
+      if(cat_sequence_counts[leaf_id] < stati_used[leaf_id]) return false;
     }
 
-    stati_used[bb_status]++;
-    if(stati_seq.at(bb_status) < stati_used.at(bb_status)) return false;
+    stati_used.add(bb_id);
+    if(cat_sequence_counts[bb_id] < stati_used[bb_id]) return false;
 
     return true;
   }
 
-  // update a config given by a recursive call of the dynamic programming
+  // the first half of a config is not updated for the virtual left center (a unique center is counted on the right)
+  inline bool is_virtual_left_center(const sequence_t& stati_seq,
+                                     const leaf_guess_t& guess,
+                                     const uint next_status,
+                                     const uint center_status)
+  {
+    return (next_status == center_status) && (stati_seq.at(center_status) == 1) && (guess.leaves == 0);
+  }
+
+  // update the stati used by a config given by a recursive call of the dynamic programming
+  // return whether they are still supported by the sequence
+  bool update_stati_used(dense_multiset& stati_used,
+                         const sequence_t& stati_seq,
+                         const pair<bool, bool>& update_who,
+                         const pair<leaf_guess_t, leaf_guess_t>& guess,
+                         const uint next_status,
+                         const uint bb_id,
+                         const uint leaf_id,
+                         const uint center_status)
+  {
+    if(update_who.first){
+      if(is_virtual_left_center(stati_seq, guess.first, next_status, center_status)){
+        DEBUG2(cout << "skipping update for virtual left center"<<endl);
+      } else if(!update_attachments(stati_used, bb_id, leaf_id, guess.first.leaves))
+        return false;
+    }
+    if(update_who.second)
+      if(!update_attachments(stati_used, bb_id, leaf_id, guess.second.leaves))
+        return false;
+    return true;
+  }
+
+  // update a config given by a recursive call of the dynamic programming (for the mirrored inputs if mirrored is set)
   pair<bool, cat_dynprog_config> update_config(const cat_dynprog_config& c,
                      const sequence_t& stati_seq,
                      const pair<bool, bool>& update_who,
                      const pair<leaf_guess_t, leaf_guess_t>& guess,
                      const uint next_status,
-                     const uint leaf_status,
-                     const uint center_status)
+                     const uint bb_id,
+                     const uint leaf_id,
+                     const uint center_status,
+                     const bool mirrored)
   {
     // prepare container to hold the result
     pair<bool, cat_dynprog_config> result(true, c);
     cat_dynprog_config& rc(result.second);
 
-    if(update_who.first){
-      if((next_status == center_status) && (stati_seq.at(center_status) == 1) && (guess.first.leaves == 0)){
-        DEBUG2(cout << "skipping update for virtual left center"<<endl);
-      } else {
-        if(!update_attachments(rc.stati_used, stati_seq, next_status, leaf_status, center_status, guess.first.leaves)){
-          result.first = false;
-          return result;
-        }
-        update_config_tree(rc.inner_cat, rc.docks.first, guess.first.leaves);
-      }
-    }
-    if(update_who.second){
-      if(!update_attachments(rc.stati_used, stati_seq, next_status, leaf_status, center_status, guess.second.leaves)){
-        result.first = false;
-        return result;
-      }
+    result.first = update_stati_used(rc.stati_used, stati_seq, update_who, guess, next_status, bb_id, leaf_id, center_status);
+    if(!result.first) return result;
+    if(mirrored) swap(rc.docks.first, rc.docks.second);
+    if(update_who.first && !is_virtual_left_center(stati_seq, guess.first, next_status, center_status))
+      update_config_tree(rc.inner_cat, rc.docks.first, guess.first.leaves);
+    if(update_who.second)
       update_config_tree(rc.inner_cat, rc.docks.second, guess.second.leaves);
-    }
     return result;
   }
 
+  // return whether the pending updates of the levels above turn c into a config using exactly the stati of the sequence
+  bool completes(const cat_dynprog_config& c, const sequence_t& stati_seq, const uint center_status){
+    dense_multiset used(c.stati_used);
+    for(size_t i = cat_pending.size(); i-- > 0;){
+      const cat_pending_update& u(cat_pending[i]);
+      if(!update_stati_used(used, stati_seq, u.update_who, u.guess, u.next_status, u.bb_id, u.leaf_id, center_status)) return false;
+    }
+    return used == cat_sequence_counts;
+  }
+
+  // apply the pending updates of the levels above to c, giving the caterpillar
+  tree* complete_solution(const cat_dynprog_config& c, const sequence_t& stati_seq, const uint center_status){
+    cat_dynprog_config result(c);
+    for(size_t i = cat_pending.size(); i-- > 0;){
+      const cat_pending_update& u(cat_pending[i]);
+      result = update_config(result, stati_seq, u.update_who, u.guess, u.next_status, u.bb_id, u.leaf_id, center_status, u.mirrored).second;
+    }
+    return result.release();
+  }
+
+
+  // the leaves of a guess that go to the side with more vertices so far
+  inline uint guess_rank(const pair<leaf_guess_t, leaf_guess_t>& g, const cat_dynprog_input_pair& inputs){
+    return (inputs.first.subtree <= inputs.second.subtree) ? g.second.leaves : g.first.leaves;
+  }
+
+  // a guess is redundant if another guess puts the same numbers of leaves on each side (only the leaves matter to the
+  // recursion, not which backbone the remaining vertices go to), or if the inputs are symmetric and the mirror image of
+  // the guess has less leaves on the first side (unless the first side of the mirror image stays open)
+  bool is_redundant_guess(const pair<leaf_guess_t, leaf_guess_t>& g,
+                          const vector<pair<leaf_guess_t, leaf_guess_t> >& guesses,
+                          const cat_dynprog_input_pair& inputs,
+                          const pair<bool, bool>& advance_who)
+  {
+    if(advance_who.first && advance_who.second && (inputs.first == inputs.second))
+      if((g.first.leaves > g.second.leaves) && ((g.second.leaves > 0) || !(inputs.first == NO_INPUT))) return true;
+    for(const auto& h : guesses)
+      if((h.first.leaves == g.first.leaves) && (h.second.leaves == g.second.leaves)) return true;
+    return false;
+  }
+
+  // sort the guesses of a level so that those putting the leaves on the smaller side come first: the subtree and influx
+  // of the smaller side are closer to their bounds, so these guesses are the most constrained and fail or succeed soonest
+  void order_guesses(vector<pair<leaf_guess_t, leaf_guess_t> >& guesses, const cat_dynprog_input_pair& inputs){
+    stable_sort(guesses.begin(), guesses.end(), [&](const pair<leaf_guess_t, leaf_guess_t>& x, const pair<leaf_guess_t, leaf_guess_t>& y){
+        return guess_rank(x, inputs) < guess_rank(y, inputs);
+      });
+  }
+
+  // the answer of calls that fail or are cut short by a solution
+  const cat_dynprog_configs cat_no_configs;
 
   // forward-declare dynamic programming
-  cat_dynprog_configs caterpillar_dynprog(const sequence_t&,
+  const cat_dynprog_configs& caterpillar_dynprog(const sequence_t&,
                                           const list<uint>&,
                                           const cat_dynprog_input_pair&,
                                           const uint);
@@ -317,6 +371,10 @@ namespace status{
     // 3. take 1 step inwards to get the new input values
     const uint center_status(stati_list.front());
     const uint leaf_status(get_corresponding_leaf_status(next_status, num_vertices));
+    // the IDs of the stati that the configs below use additionally, looked up once for all of them (the leaf status
+    // only occurs if the guess has leaves)
+    const uint bb_id(cat_status_ids.at(next_status));
+    const uint leaf_id(get_status_id(leaf_status));
 
     // don't update the first input if it is NO_INPUT and the guess says that it's not getting any leaves
     if((inputs.first == NO_INPUT) && (guess.first.leaves == 0)) update_who.first = false;
@@ -342,18 +400,29 @@ namespace status{
     cat_dynprog_configs result;
     // make sure the inputs are sane
     if(is_sane(new_inputs.first, stati_seq, num_vertices) && is_sane(new_inputs.second, stati_seq, num_vertices)){
+      // ask the table for the mirror image if that's the one it keeps
+      const bool mirrored(is_mirrored(new_inputs));
+      if(mirrored) swap(new_inputs.first, new_inputs.second);
       // recursive call to the previous layer of the dynamic programming table
-      cat_dynprog_configs tmp(caterpillar_dynprog(stati_seq, stati_list, new_inputs, num_vertices));
+      if(cat_options.first_solution) cat_pending.push_back((cat_pending_update){update_who, guess, next_status, bb_id, leaf_id, mirrored});
+      const cat_dynprog_configs& tmp(caterpillar_dynprog(stati_seq, stati_list, new_inputs, num_vertices));
+      if(cat_options.first_solution) cat_pending.pop_back();
+      if(cat_solution) return result;
 
       // remove all configurations that do not support our old inputs
-      for(cat_dynprog_config c : tmp){
+      for(const cat_dynprog_config& c : tmp){
         DEBUG2(cout << "used so far: "<<c.stati_used<<", want to add: "<<next_status<<" & "<<guess.first.leaves+guess.second.leaves<<'x'<<leaf_status<<endl);
-        pair<bool, cat_dynprog_config> updated(update_config(c, stati_seq, update_who, guess, next_status, leaf_status, center_status));
+        pair<bool, cat_dynprog_config> updated(update_config(c, stati_seq, update_who, guess, next_status, bb_id, leaf_id, center_status, mirrored));
         if(updated.first){
           DEBUG2(cout << "supported, now used "<< updated.second.stati_used<<endl);
+          // if the levels above can finish this config, we're done
+          if(cat_options.first_solution && completes(updated.second, stati_seq, center_status)){
+            cat_solution = complete_solution(updated.second, stati_seq, center_status);
+            return result;
+          }
           // if we're at the top level (indicated by input NO_INPUT,NO_INPUT), no more stati should be attached
           if((inputs.first == NO_INPUT) && (inputs.second == NO_INPUT)){
-            if(equal(stati_seq, updated.second.stati_used)) result.insert(updated.second); else
+            if(updated.second.stati_used == cat_sequence_counts) result.insert(updated.second); else
               DEBUG2(cout<< updated.second.stati_used << " does not exactly use our stati, discarding"<<endl);
           } else result.insert(updated.second);
         } else DEBUG2(cout << "not supported!"<<endl);
@@ -364,22 +433,31 @@ namespace status{
   }
 
   // do the dynamic programming
-  cat_dynprog_configs caterpillar_dynprog(const sequence_t& stati_seq,
-                                          const list<uint>& stati_list,
-                                          const cat_dynprog_input_pair& inputs,
-                                          const uint num_vertices)
+  // the configs are returned by reference into the table (or to cat_no_configs), so that looking up an entry copies nothing
+  const cat_dynprog_configs& caterpillar_dynprog(const sequence_t& stati_seq,
+                                                 const list<uint>& stati_list,
+                                                 const cat_dynprog_input_pair& inputs,
+                                                 const uint num_vertices)
   {
-    // if cat_DP_table has not yet been initialized, do so first
-    if(!cat_DP_table_initialized) caterpillar_dynprog_initialize(stati_seq, stati_list, num_vertices);
     // if it's in the DP table, use it
     { const auto lookup(cat_DP_table.find(inputs));
       if(lookup != cat_DP_table.end()){
         DEBUG2(cout << "=== found "<<inputs<<" with "<<lookup->second.size()<<" entries in the table:"<<endl);
         return lookup->second;
     }}
-    DEBUG2(cout << inputs << " not found in the table, computing..."<<endl);
     // get the center status
     const uint center_status(stati_list.front());
+    // at the center, start with an empty inner caterpillar
+    if(is_center_input_pair(inputs, center_status, stati_seq.at(center_status), num_vertices)){
+      cat_dynprog_config config;
+      config.inner_cat = new tree();
+      config.stati_used = dense_multiset(cat_id_stati.size());
+      cat_dynprog_configs& confs(cat_DP_table[inputs]);
+      confs.insert(config);
+      DEBUG2(cout << "center entry T"<<inputs<<"="<<confs<<endl);
+      return confs;
+    }
+    DEBUG2(cout << inputs << " not found in the table, computing..."<<endl);
     // prepare container to hold result
     cat_dynprog_configs result;
     // the next status
@@ -397,25 +475,22 @@ namespace status{
       if(inputs.first == NO_INPUT){
         if(inputs.second.status == center_status){
           // if we're at the center, but inputs.first == NO_INPUT, then just give it [x 1 x], where x is the canter status
-          result = caterpillar_dynprog(stati_seq, stati_list,
+          return caterpillar_dynprog(stati_seq, stati_list,
               make_pair( (cat_dynprog_input){
                   center_status, // status
                   1,             // subtree
                   center_status  // influx
                 }, inputs.second),
               num_vertices);
-          // register the center as used in all configs
-          for(auto c : result) c.stati_used[center_status]++;
-          return result;
         } else {
           // if we found something invalid, return failure
-          if((next_status > inputs.second.status) || (stati_seq.find(next_status) == stati_seq.end())) return cat_dynprog_configs();
+          if((next_status > inputs.second.status) || (stati_seq.find(next_status) == stati_seq.end())) return cat_no_configs;
           // if the first input is NO_INPUT but the second is not (and its not the center)
           // include the first input in the guesswork (if the sequence supports another backbone vertex of this status)
           if(stati_seq.at(next_status) > 1) advance_who.first = true;
           // recurse for every input status strictly between the first and its adjacent next one
           DEBUG2(cout << "checking if anyone between "<<next_status<<" and "<<inputs.second.status<<" in "<<stati_list<<" could be at the left end"<<endl);
-          for(list<uint>::const_iterator i = stati_list.begin(); *i < inputs.second.status; ++i) if(*i > next_status) {
+          for(list<uint>::const_iterator i = stati_list.begin(); (*i < inputs.second.status) && !cat_solution; ++i) if(*i > next_status) {
             DEBUG2(cout << *i << " is a candidate for the left end"<<endl);
             const uint leaf_status(get_corresponding_leaf_status(*i, num_vertices));
             const sequence_t::const_iterator leaf_occurances = stati_seq.find(leaf_status);
@@ -427,7 +502,7 @@ namespace status{
               unordered_set_union(result, dynprog_recurse_for_guess(stati_seq, stati_list, *i, inputs, make_pair(true, false),
                     make_pair( (leaf_guess_t){ 0, leaf_occurances->second }, NEW_GUESS), num_vertices));
               // maybe leaf_status occurs also on the backbone on the right, so try using 1 leaf less
-              if(leaf_occurances->second > 1)
+              if((leaf_occurances->second > 1) && !cat_solution)
                 unordered_set_union(result, dynprog_recurse_for_guess(stati_seq, stati_list, *i, inputs, make_pair(true, false),
                       make_pair( (leaf_guess_t){ 0, leaf_occurances->second - 1 }, (leaf_guess_t){ 1, 0 }), num_vertices));
             }
@@ -436,13 +511,15 @@ namespace status{
         }
       } else {
         // if none of the input stati is NO_INPUT, but we're over the center, then return failure
-        if(next_status >= inputs.second.status) return cat_dynprog_configs();
+        if(next_status >= inputs.second.status) return cat_no_configs;
         // also, if the status we computed doesn't exist, return failure
-        if(stati_seq.find(next_status) == stati_seq.end()) return cat_dynprog_configs();
+        if(stati_seq.find(next_status) == stati_seq.end()) return cat_no_configs;
 
 
         // check if the adjacent status on the left is larger than on the right
         const uint tmp(get_adjacent_status(inputs.first.status, inputs.first.subtree, num_vertices));
+        // the same goes for the left, so that mirrored inputs fail alike
+        if((tmp >= inputs.first.status) || (stati_seq.find(tmp) == stati_seq.end())) return cat_no_configs;
         // and if so, update next_status
         if(tmp > next_status){
           next_status = tmp;
@@ -460,6 +537,7 @@ namespace status{
     // branch into partitions of the vertices of next status:
     // backbone left? backbone right? #leaves left? #leaves right?
     pair<leaf_guess_t, leaf_guess_t> guess;
+    vector<pair<leaf_guess_t, leaf_guess_t> > guesses;
 
     DEBUG2(cout << next_status << " corresponds to "<<next_leaf_status<<" which occurs "<<next_occurances<<"x"<<endl);
     const uint max_bb_first(min(1U, next_occurances));
@@ -476,44 +554,116 @@ namespace status{
         DEBUG2(cout << "max guess for first leaves: "<< (advance_who.first ? num_leaves : 0) <<endl);
         for(guess.first.leaves = (advance_who.second ? 0 : num_leaves); guess.first.leaves <= ( advance_who.first ? num_leaves : 0); ++guess.first.leaves){
           guess.second.leaves = num_leaves - guess.first.leaves;
-          DEBUG2(cout << "guessed distribution "<<guess<<" of "<<next_leaf_status<<endl);
-
-          unordered_set_union(result, dynprog_recurse_for_guess(stati_seq, stati_list, next_status, inputs, advance_who, guess, num_vertices));
-          DEBUG2(cout << "results for inputs "<<inputs<<" augmented to "<<result<<endl);
+          if(!is_redundant_guess(guess, guesses, inputs, advance_who)) guesses.push_back(guess);
         }
       }
     }
+    if(cat_options.order_guesses) order_guesses(guesses, inputs);
+
+    for(const auto& g : guesses){
+      DEBUG2(cout << "guessed distribution "<<g<<" of "<<next_leaf_status<<endl);
+      unordered_set_union(result, dynprog_recurse_for_guess(stati_seq, stati_list, next_status, inputs, advance_who, g, num_vertices));
+      DEBUG2(cout << "results for inputs "<<inputs<<" augmented to "<<result<<endl);
+      // the partial result must not go to the table
+      if(cat_solution) return cat_no_configs;
+    }
 
     // add the result to the dynamic programming table
-    cat_DP_table[inputs] = result;
+    cat_dynprog_configs& entry(cat_DP_table[inputs]);
+    entry.swap(result);
+    if(cat_journal) cat_journal->record(inputs, entry);
     // keep track of list sizes
-    largest_set_list = max(largest_set_list, result.size());
+    largest_set_list = max(largest_set_list, entry.size());
 
-    return result;
+    return entry;
+  }
+
+  // forget the table of the previous sequence
+  void reset_caterpillar_dynprog(){
+    cat_DP_table.clear();
+    largest_set_list = 0;
+    cat_pending.clear();
+    cat_solution = NULL;
   }
 
-  tree* stati_to_caterpillar(const sequence_t& s){
+  // number the stati of s (sorted in stati) by rank
+  void number_stati(const sequence_t& s, const list<uint>& stati){
+    cat_id_stati.assign(stati.begin(), stati.end());
+    cat_status_ids.clear();
+    cat_sequence_counts = dense_multiset(cat_id_stati.size());
+    for(uint id = 0; id < cat_id_stati.size(); ++id){
+      cat_status_ids[cat_id_stati[id]] = id;
+      cat_sequence_counts.set(id, s.at(cat_id_stati[id]));
+    }
+  }
+
+  tree* stati_to_caterpillar(const sequence_t& s, const solv_options& opts, sequence_verdict* const verdict){
+    cat_options = opts;
+    // reject what cannot be the sequence of any tree before building the table
+    const sequence_verdict v(prefilter_sequence(s));
+    if(verdict) *verdict = v;
+    if(v != SEQUENCE_OK) return NULL;
+
+    const uint num_vertices(get_num_vertices(s));
+    // the only trees with less than two different stati are the paths on 1 and 2 vertices
+    if(num_vertices <= 2){
+      tree* const result(new tree());
+      for(vertex* u = NULL; result->get_size() < num_vertices;) u = result->add_vertex(u);
+      return result;
+    }
+
+    // a sequence we have seen before need not be solved again
+    if(opts.cache)
+      switch(opts.cache->lookup(s, cat_leaves)){
+        case CACHE_CATERPILLAR: return caterpillar_from_leaves(cat_leaves.data(), cat_leaves.size());
+        case CACHE_NO_CATERPILLAR: return NULL;
+        default: break;
+      }
+
     // we rather work with a (sorted) list of stati
     list<uint> stati(get_occuring_stati(s));
     stati.sort();
 
     DEBUG2(cout << "stati: "<<stati<<endl);
 
-    // let's say we have at least two stati
-    assert(stati.size() > 1);
+    reset_caterpillar_dynprog();
+    number_stati(s, stati);
 
-    // construct the inputs
-    cat_dynprog_input_pair inputs;
-    pair<uint, uint> leaves;
-
-    const uint num_vertices(get_num_vertices(s));
+    // continue from the journal of an earlier attempt (if any) and keep the journal up to date
+    unique_ptr<cat_checkpoint> journal;
+    if(!opts.checkpoint_file.empty()){
+      journal.reset(new cat_checkpoint(opts.checkpoint_file, s, cat_DP_table, opts.checkpoint_interval));
+      for(const auto& entry : cat_DP_table) largest_set_list = max(largest_set_list, entry.second.size());
+    }
+    cat_journal = journal.get();
+    const cat_dynprog_configs& confs(caterpillar_dynprog(s, stati, cat_dynprog_input_pair(NO_INPUT, NO_INPUT), num_vertices));
+    cat_journal = NULL;
+    // if successfull, return the first possible tree (in first_solution mode, the table has it only if it came from a journal)
+    tree* result(cat_solution);
+    if(!result && !confs.empty()){
+      cat_dynprog_config first(*confs.begin());
+      result = first.release();
+    }
 
-    cat_dynprog_configs confs(caterpillar_dynprog(s, stati, cat_dynprog_input_pair(NO_INPUT, NO_INPUT), num_vertices));
-    // and, if successfull, return the first possible tree
-    if(!confs.empty()) return confs.begin()->inner_cat; else return NULL;
+    if(opts.cache){
+      if(result){
+        cat_backbone.resize(num_vertices);
+        cat_leaves.resize(num_vertices);
+        const uint length(recognize_caterpillar(*result, cat_backbone.data(), cat_leaves.data()));
+        opts.cache->insert(s, CACHE_CATERPILLAR, cat_leaves.data(), length);
+      } else opts.cache->insert(s, CACHE_NO_CATERPILLAR);
+    }
+    return result;
   }
 
   size_t get_set_list_max(){ return largest_set_list; }
+  size_t get_table_size(){ return cat_DP_table.size(); }
+  uint get_status_id(const uint s){
+    const auto i(cat_status_ids.find(s));
+    return (i == cat_status_ids.end()) ? UINT_MAX : i->second;
+  }
+  uint get_id_status(const uint id){ return cat_id_stati[id]; }
+  uint get_num_status_ids(){ return cat_id_stati.size(); }
 }
 
 std::ostream& operator<<(std::ostream& os, const status::cat_dynprog_input& i){
@@ -3,10 +3,21 @@
 
 #include "../util/seq.hpp"
 #include "../util/graphs.hpp"
+#include "../util/compact_set.hpp"
+#include "prefilter.hpp"
+#include "options.hpp"
+#include "cache.hpp"
 
 namespace status{
 
   size_t get_set_list_max();
+  // the number of entries in the table of the last call to stati_to_caterpillar (in this thread)
+  size_t get_table_size();
+  // the stati of the sequence being reconstructed (in this thread) are numbered by rank and configs count the stati they
+  // use by these IDs: the ID of a status (UINT_MAX if it does not occur), the status of an ID and the number of IDs
+  uint get_status_id(const uint s);
+  uint get_id_status(const uint id);
+  uint get_num_status_ids();
 
   struct cat_dynprog_input {
     uint status;
@@ -57,47 +68,72 @@ namespace status{
     // the inner caterpillar with two docking vertices (far left & right on backbone)
     tree* inner_cat;
     pair<vertex*, vertex*> docks;
-    // save which stati we used how often
-    sequence_t stati_used;
+    // save which stati we used how often (by their IDs, see get_status_id)
+    dense_multiset stati_used;
 
 
     cat_dynprog_config():inner_cat(NULL),docks(NULL,NULL){}
-    // TODO write desctructor!!
     // copy constructor, using copy constructor of status_set_t
-    cat_dynprog_config(const cat_dynprog_config& config):stati_used(config.stati_used){
+    cat_dynprog_config(const cat_dynprog_config& config):inner_cat(NULL),docks(NULL,NULL),stati_used(config.stati_used){
       // copy the tree and the docks
+      if(!config.inner_cat) return;
       unordered_map<const vertex*, vertex*> preserve;
       inner_cat = copy_tree_preserving(*config.inner_cat, preserve);
       if(config.docks.first) docks.first = preserve.at(config.docks.first);
       if(config.docks.second) docks.second = preserve.at(config.docks.second);
     }
+    // moving hands the inner caterpillar over without copying it
+    cat_dynprog_config(cat_dynprog_config&& config):inner_cat(config.inner_cat),docks(config.docks),stati_used(move(config.stati_used)){
+      config.inner_cat = NULL;
+    }
+    cat_dynprog_config& operator=(cat_dynprog_config config){
+      swap(inner_cat, config.inner_cat);
+      swap(docks, config.docks);
+      swap(stati_used, config.stati_used);
+      return *this;
+    }
+    // each config owns its inner caterpillar
+    ~cat_dynprog_config(){
+      if(inner_cat){
+        inner_cat->clear();
+        delete inner_cat;
+      }
+    }
+    // hand the inner caterpillar over to the caller
+    inline tree* release(){
+      tree* const result(inner_cat);
+      inner_cat = NULL;
+      return result;
+    }
     // equality means equality of used stati, we actually don't care about how the graph looks
     inline bool operator==(const cat_dynprog_config& conf) const {
-      return equal(stati_used, conf.stati_used);
+      return stati_used == conf.stati_used;
     }
   };
 
   class config_hasher{
   public:
-    // config hasher: roll each status s to the left by x bits, where x is the #occurances of s mod sizeof(uint)
-    uint operator()(const cat_dynprog_config& conf) const{
-      uint result = 0;
-      for(auto entry: conf.stati_used)
-        result += rol(entry.first, (entry.second % sizeof(uint)));
-      return result;
+    // config hasher: hash the multiplicities of the stati used
+    size_t operator()(const cat_dynprog_config& conf) const{
+      return conf.stati_used.hash();
     }
   };
 
 
   
   typedef unordered_set<cat_dynprog_config, config_hasher> cat_dynprog_configs;
+  typedef unordered_map<cat_dynprog_input_pair, cat_dynprog_configs, input_pair_hasher> cat_dynprog_table;
 
   bool operator==(const cat_dynprog_input& X, const cat_dynprog_input& Y);
   bool operator==(const cat_dynprog_input_pair& X, const cat_dynprog_input_pair& Y);
 
 
-  // reconstruct a caterpillar from a given status sequence
-  tree* stati_to_caterpillar(const sequence_t& s);
+  // reconstruct a caterpillar from a given status sequence (the caller owns the result); the table is kept per thread, so
+  // each thread may reconstruct its own caterpillars; sequences that fail the pre-filter are rejected before
+  // building the table and the reason is written to verdict (if given); sequences passing the pre-filter are looked up
+  // in opts.cache (if given) before building the table, and new answers are stored there; with opts.checkpoint_file, the
+  // table is journaled as it grows and a journal left by an earlier attempt is read back first
+  tree* stati_to_caterpillar(const sequence_t& s, const solv_options& opts = solv_options(), sequence_verdict* const verdict = NULL);
 
   // get the status of leaves attached to a backbone vertex with status s
   inline uint get_corresponding_leaf_status(const uint s, const uint num_vertices){
@@ -0,0 +1,220 @@
+#include "checkpoint.hpp"
+#include "../util/random.hpp"
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CHECKPOINT_MAGIC 0x4b48435441545300ULL
+#define CHECKPOINT_VERSION 1
+// the parent of the root and a missing dock
+#define CHECKPOINT_NO_VERTEX UINT32_MAX
+
+namespace status {
+
+  // the checksum of the payload of a record
+  inline uint64_t checkpoint_checksum(const uint32_t* const words, const size_t num_words){
+    uint64_t result(mix64(num_words));
+    for(size_t i = 0; i < num_words; ++i) result = mix64(result ^ words[i]);
+    return result;
+  }
+
+  // the start of a journal: magic, version and the sorted (status, multiplicity) pairs of the sequence
+  void checkpoint_header(const sequence_t& s, vector<uint32_t>& header){
+    vector<pair<uint, uint> > sorted(s.begin(), s.end());
+    sort(sorted.begin(), sorted.end());
+    header.clear();
+    header.push_back((uint32_t)CHECKPOINT_MAGIC);
+    header.push_back((uint32_t)(CHECKPOINT_MAGIC >> 32));
+    header.push_back(CHECKPOINT_VERSION);
+    header.push_back(sorted.size());
+    for(const auto& p : sorted){
+      header.push_back(p.first);
+      header.push_back(p.second);
+    }
+  }
+
+  inline void encode_input(const cat_dynprog_input& x, vector<uint32_t>& words){
+    words.push_back(x.status);
+    words.push_back(x.subtree);
+    words.push_back(x.influx);
+  }
+
+  // the vertices of an inner caterpillar are numbered in the order they were added, so parents come before children
+  void encode_config(const cat_dynprog_config& c, vector<uint32_t>& words){
+    words.push_back(c.stati_used.distinct());
+    for(uint id = 0; id < c.stati_used.get_universe(); ++id)
+      if(c.stati_used[id]){
+        words.push_back(get_id_status(id));
+        words.push_back(c.stati_used[id]);
+      }
+    assert(c.inner_cat);
+    const tree& t(*c.inner_cat);
+    words.push_back(t.get_size());
+    for(uint i = 0; i < t.get_size(); ++i){
+      const vertex* const parent(t.get_vertex(i)->get_parent());
+      words.push_back(parent ? parent->get_id() : CHECKPOINT_NO_VERTEX);
+    }
+    words.push_back(c.docks.first ? c.docks.first->get_id() : CHECKPOINT_NO_VERTEX);
+    words.push_back(c.docks.second ? c.docks.second->get_id() : CHECKPOINT_NO_VERTEX);
+  }
+
+  // reads the payload of a record word by word, noticing when it runs out
+  struct checkpoint_reader {
+    const uint32_t* next;
+    const uint32_t* const end;
+
+    inline bool get(uint32_t& x){
+      if(next == end) return false;
+      x = *next++;
+      return true;
+    }
+    inline bool get(cat_dynprog_input& x){ return get(x.status) && get(x.subtree) && get(x.influx); }
+  };
+
+  // decode a config, return false if the payload does not describe one
+  bool decode_config(checkpoint_reader& r, cat_dynprog_config& c){
+    uint32_t num_stati, size, parent, first, second;
+    if(!r.get(num_stati)) return false;
+    c.stati_used = dense_multiset(get_num_status_ids());
+    for(uint32_t i = 0; i < num_stati; ++i){
+      uint32_t s, multiplicity;
+      if(!r.get(s) || !r.get(multiplicity)) return false;
+      const uint id(get_status_id(s));
+      if(id == UINT_MAX) return false;
+      c.stati_used.add(id, multiplicity);
+    }
+    if(!r.get(size)) return false;
+    c.inner_cat = new tree();
+    for(uint32_t i = 0; i < size; ++i){
+      if(!r.get(parent)) return false;
+      if((parent == CHECKPOINT_NO_VERTEX) ? (i != 0) : (parent >= i)) return false;
+      c.inner_cat->add_vertex(i ? c.inner_cat->get_vertex(parent) : NULL);
+    }
+    if(!r.get(first) || !r.get(second)) return false;
+    if(first != CHECKPOINT_NO_VERTEX){
+      if(first >= size) return false;
+      c.docks.first = c.inner_cat->get_vertex(first);
+    }
+    if(second != CHECKPOINT_NO_VERTEX){
+      if(second >= size) return false;
+      c.docks.second = c.inner_cat->get_vertex(second);
+    }
+    return true;
+  }
+
+  cat_checkpoint::cat_checkpoint(const string filename, const sequence_t& s, cat_dynprog_table& table, const uint _interval):
+    fd(open(filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644)), interval(_interval), replayed(0), stopping(false)
+  {
+    if(fd < 0) FAIL("unable to open the journal "<<filename);
+    // two solvers appending to the same journal would garble it
+    if(flock(fd, LOCK_EX | LOCK_NB)) FAIL("the journal "<<filename<<" is in use");
+    replay(filename, s, table);
+    writer = thread(&cat_checkpoint::write_pending, this);
+  }
+
+  cat_checkpoint::~cat_checkpoint(){
+    {
+      lock_guard<mutex> guard(pending_lock);
+      stopping = true;
+    }
+    wakeup.notify_one();
+    writer.join();
+    close(fd);
+  }
+
+  void cat_checkpoint::replay(const string& filename, const sequence_t& s, cat_dynprog_table& table){
+    vector<uint32_t> header;
+    checkpoint_header(s, header);
+    struct stat st;
+    if(fstat(fd, &st)) FAIL("unable to stat the journal "<<filename);
+    if(st.st_size == 0){
+      if(write(fd, header.data(), header.size() * sizeof(uint32_t)) != (ssize_t)(header.size() * sizeof(uint32_t)))
+        FAIL("unable to write the journal "<<filename);
+      return;
+    }
+
+    const size_t num_words(st.st_size / sizeof(uint32_t));
+    void* const m(mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0));
+    if(m == MAP_FAILED) FAIL("unable to map the journal "<<filename);
+    const uint32_t* const words((const uint32_t*)m);
+    if((num_words < header.size()) || !equal(header.begin(), header.end(), words))
+      FAIL(filename<<" is not a journal of this sequence");
+
+    // each record: length, payload, checksum (2 words)
+    size_t pos(header.size());
+    while(pos < num_words){
+      const uint32_t length(words[pos]);
+      if(num_words - pos < (size_t)length + 3) break;
+      const uint32_t* const payload(words + pos + 1);
+      const uint64_t sum(checkpoint_checksum(payload, length));
+      if((payload[length] != (uint32_t)sum) || (payload[length + 1] != (uint32_t)(sum >> 32))) break;
+
+      checkpoint_reader r = { payload, payload + length };
+      cat_dynprog_input_pair inputs;
+      uint32_t num_configs;
+      if(!r.get(inputs.first) || !r.get(inputs.second) || !r.get(num_configs)) break;
+      cat_dynprog_configs confs;
+      bool intact(true);
+      for(uint32_t i = 0; intact && (i < num_configs); ++i){
+        cat_dynprog_config c;
+        if((intact = decode_config(r, c))) confs.insert(move(c));
+      }
+      if(!intact || (r.next != r.end)) break;
+      table[inputs].swap(confs);
+      ++replayed;
+      pos += length + 3;
+    }
+    munmap(m, st.st_size);
+    // new records go right after the last intact one
+    if(pos * sizeof(uint32_t) != (size_t)st.st_size)
+      if(ftruncate(fd, pos * sizeof(uint32_t))) FAIL("unable to cut the damaged end off the journal "<<filename);
+  }
+
+  void cat_checkpoint::record(const cat_dynprog_input_pair& inputs, const cat_dynprog_configs& confs){
+    lock_guard<mutex> guard(pending_lock);
+    const size_t start(pending.size());
+    // the length is filled in once we know it
+    pending.push_back(0);
+    encode_input(inputs.first, pending);
+    encode_input(inputs.second, pending);
+    pending.push_back(confs.size());
+    for(const cat_dynprog_config& c : confs) encode_config(c, pending);
+    const size_t length(pending.size() - start - 1);
+    pending[start] = length;
+    const uint64_t sum(checkpoint_checksum(pending.data() + start + 1, length));
+    pending.push_back((uint32_t)sum);
+    pending.push_back((uint32_t)(sum >> 32));
+  }
+
+  void cat_checkpoint::write_pending(){
+    unique_lock<mutex> lock(pending_lock);
+    while(true){
+      wakeup.wait_for(lock, chrono::seconds(interval), [this]{ return stopping; });
+      const bool last(stopping);
+      swap(pending, writing);
+      lock.unlock();
+
+      const char* const bytes((const char*)writing.data());
+      const size_t num_bytes(writing.size() * sizeof(uint32_t));
+      for(size_t done = 0; done < num_bytes;){
+        const ssize_t w(write(fd, bytes + done, num_bytes - done));
+        if(w < 0){
+          if(errno == EINTR) continue;
+          FAIL("unable to write the journal");
+        }
+        done += w;
+      }
+      if(num_bytes) fdatasync(fd);
+      writing.clear();
+
+      lock.lock();
+      if(last) return;
+    }
+  }
+
+};
@@ -0,0 +1,55 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include "caterpillar.hpp"
+#include <stdint.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+using namespace std;
+
+namespace status {
+
+  // a journal of the table of the caterpillar dynamic programming, so that a long solve survives a crash
+  // the table only ever receives complete entries (partial results of first_solution mode never go there), and what the
+  // table holds for some inputs depends only on the sequence, so the table can be written entry by entry as it grows and,
+  // after a crash, be read back before solving again, which then takes every entry it finds from the table
+  //
+  // the file starts with the sorted (status, multiplicity) pairs of the sequence, such that a journal is never applied to
+  // another sequence, followed by one record per entry: the number of words of its payload, the payload (the inputs and,
+  // for each config, the stati used, the inner caterpillar as array of parents and the docks) and a checksum; a record
+  // that is cut short or damaged (by the crash) ends the journal
+  //
+  // entries are encoded into a buffer by the solver and written (and synced) by a thread of the journal every few
+  // seconds, so the search never waits for the disk
+  class cat_checkpoint {
+    int fd;
+    const uint interval;
+    size_t replayed;
+    // the records waiting to be written, and those being written
+    vector<uint32_t> pending, writing;
+    mutex pending_lock;
+    condition_variable wakeup;
+    bool stopping;
+    thread writer;
+
+    void write_pending();
+    void replay(const string& filename, const sequence_t& s, cat_dynprog_table& table);
+  public:
+    // open (or create) the journal for the sequence s, failing if it belongs to another sequence, put its entries into
+    // the table and cut off a damaged end (if any); new records are written every interval seconds
+    cat_checkpoint(const string filename, const sequence_t& s, cat_dynprog_table& table, const uint interval = 10);
+    // write the remaining records
+    ~cat_checkpoint();
+
+    // the number of entries read from the journal
+    inline size_t get_replayed() const { return replayed; }
+    // add an entry of the table to the journal
+    void record(const cat_dynprog_input_pair& inputs, const cat_dynprog_configs& confs);
+  };
+
+};
+
+#endif
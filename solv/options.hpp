@@ -1,7 +1,36 @@
+#ifndef OPTIONS_HPP
+#define OPTIONS_HPP
+
+#include <cstddef>
+#include <stdint.h>
+#include <string>
 
 namespace status {
 
+  class reconstruction_cache;
+
   class solv_options {
+  public:
+    // stop as soon as one caterpillar with the sequence is found, instead of computing all configurations of each table
+    // entry (which is still useful to study how many caterpillars share a sequence)
+    bool first_solution;
+    // try the most constrained guesses first, so that first_solution finds its caterpillar sooner
+    bool order_guesses;
+    // look up sequences in this cache before solving them and remember the answers (see cache.hpp), NULL for none
+    reconstruction_cache* cache;
+    // keep a journal of the table in this file and, if it exists, continue from it (see checkpoint.hpp), "" for none
+    std::string checkpoint_file;
+    // the seconds between two writes to the journal
+    unsigned int checkpoint_interval;
+    // the number of nodes after which the search for trees that are not caterpillars gives up (see stati_to_tree)
+    uint64_t search_budget;
+    // the number of threads of this search (0 for one per core)
+    unsigned int search_threads;
+
+    solv_options(): first_solution(true), order_guesses(true), cache(NULL), checkpoint_interval(10),
+      search_budget(1ULL << 26), search_threads(0) {}
   };
 
 };
+
+#endif
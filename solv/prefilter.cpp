@@ -0,0 +1,95 @@
+#include "prefilter.hpp"
+#include <algorithm>
+#include <stdint.h>
+
+namespace status {
+
+  const char* get_verdict_description(const sequence_verdict v){
+    switch(v){
+      case SEQUENCE_OK: return "ok";
+      case EMPTY_SEQUENCE: return "empty sequence";
+      case STATUS_OUT_OF_BOUNDS: return "status out of bounds";
+      case TOO_MANY_CENTERS: return "more than 2 centers";
+      case TWO_CENTERS_ODD_ORDER: return "2 centers and odd number of vertices";
+      case PARITY: return "stati have the wrong parity";
+      case NO_LEAF_PARTNER: return "the maximum status has no neighbor";
+      case NO_PARENT_STATUS: return "some status has no neighbor towards the center";
+      case TOO_MANY_VERTICES: return "too many vertices";
+    }
+    return "unknown";
+  }
+
+  sequence_verdict prefilter_sequence(const uint* const stati, const uint n){
+    if(!n) return EMPTY_SEQUENCE;
+    const uint64_t N(n);
+    const uint s_min(stati[0]);
+    const uint s_max(stati[n - 1]);
+    if(n == 1) return s_min ? STATUS_OUT_OF_BOUNDS : SEQUENCE_OK;
+    // the star center has the smallest status, the path end the largest and the path center the largest median
+    if((s_min < n - 1) || (s_max > N * (N - 1) / 2) || (s_min > N * N / 4)) return STATUS_OUT_OF_BOUNDS;
+
+    uint centers = 1;
+    while((centers < n) && (stati[centers] == s_min)) ++centers;
+    if(centers > 2) return TOO_MANY_CENTERS;
+    // two centers are adjacent and have n/2 vertices on each side
+    if((centers == 2) && (n & 1)) return TWO_CENTERS_ODD_ORDER;
+
+    // count odd stati, look for the neighbor of the maximum and find the largest gap between consecutive stati
+    const uint partner(s_max - (n - 2));
+    uint odd = 0;
+    uint partner_found = 0;
+    uint max_gap = 0;
+    assert(is_sorted(stati, stati + n));
+    for(uint i = 1; i < n; ++i){
+      odd += stati[i] & 1;
+      partner_found |= (stati[i] == partner);
+      max_gap = max(max_gap, stati[i] - stati[i - 1]);
+    }
+    odd += s_min & 1;
+    partner_found |= (s_min == partner);
+
+    // the stati of adjacent vertices differ by n - 2k, so for even n, all stati have the same parity; for odd n, the
+    // stati of each color class of the bipartition have the same parity and the number of odd ones is even
+    if(n & 1){
+      if(odd & 1) return PARITY;
+    } else if(odd && (odd != n)) return PARITY;
+    if(!partner_found) return NO_LEAF_PARTNER;
+    // the neighbor towards the center is at most n-2 smaller, so the same holds for the next smaller status
+    if(max_gap > n - 2) return NO_PARENT_STATUS;
+
+    // for odd n, the neighbor towards the center has the other parity
+    if(n & 1){
+      // the largest status of each parity seen so far
+      uint last[2] = {UINT_MAX, UINT_MAX};
+      last[s_min & 1] = s_min;
+      for(uint i = centers; i < n; ++i){
+        const uint s(stati[i]);
+        if(s == stati[i - 1]) continue;
+        last[stati[i - 1] & 1] = stati[i - 1];
+        const uint below(last[(s & 1) ^ 1]);
+        if((below == UINT_MAX) || (s - below > n - 2)) return NO_PARENT_STATUS;
+      }
+    }
+    return SEQUENCE_OK;
+  }
+
+  sequence_verdict prefilter_sequence(const sequence_t& s){
+    // the number of vertices has to fit into a uint before we make room for the stati
+    uint64_t n = 0;
+    for(const auto& entry : s) n += entry.second;
+    if(n > UINT_MAX) return TOO_MANY_VERTICES;
+    vector<uint> stati;
+    stati.reserve(n);
+    for(const auto& entry : s) stati.insert(stati.end(), entry.second, entry.first);
+    sort(stati.begin(), stati.end());
+    return prefilter_sequence(stati.data(), stati.size());
+  }
+
+  void prefilter_sequences(const vector<uint>& stati, const vector<size_t>& offset, vector<sequence_verdict>& result){
+    assert(!offset.empty());
+    result.resize(offset.size() - 1);
+    for(size_t i = 0; i + 1 < offset.size(); ++i)
+      result[i] = prefilter_sequence(stati.data() + offset[i], offset[i + 1] - offset[i]);
+  }
+
+};
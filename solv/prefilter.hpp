@@ -0,0 +1,37 @@
+#ifndef PREFILTER_HPP
+#define PREFILTER_HPP
+
+#include "../util/seq.hpp"
+#include <vector>
+
+namespace status {
+
+  // why a sequence cannot be the status sequence of a tree (SEQUENCE_OK if we could not tell)
+  enum sequence_verdict {
+    SEQUENCE_OK = 0,
+    EMPTY_SEQUENCE,
+    STATUS_OUT_OF_BOUNDS,   // some status is below n-1 or above n(n-1)/2, or the minimum is above n²/4
+    TOO_MANY_CENTERS,       // the minimum status occurs more than twice
+    TWO_CENTERS_ODD_ORDER,  // the minimum status occurs twice, but the number of vertices is odd
+    PARITY,                 // n is even but the stati have different parity, or the stati add up to an odd number
+    NO_LEAF_PARTNER,        // the maximum status s (a leaf) has no neighbor of status s-(n-2)
+    NO_PARENT_STATUS,       // some non-center status s has no smaller status s-d with d <= n-2 and d = n mod 2
+    TOO_MANY_VERTICES       // the multiplicities add up to 2^32 or more (or to more than the server accepts)
+  };
+
+  const char* get_verdict_description(const sequence_verdict v);
+
+  // check necessary conditions for a sorted status sequence (with repetitions) of n vertices, without any allocation:
+  // a vertex v that is not a center has a neighbor towards the center with status s(v) - (n - 2k), where k < n/2 is the
+  // number of vertices behind v; in particular, a leaf of maximum status has a neighbor of status s(v) - (n - 2)
+  // the counting is done in one pass that the compiler can vectorize; only for odd n, the distance to the nearest
+  // smaller status of the other parity needs a second (scalar) pass
+  sequence_verdict prefilter_sequence(const uint* const stati, const uint n);
+  // the same for a sequence_t (this sorts the stati first, unless there are 2^32 or more of them)
+  sequence_verdict prefilter_sequence(const sequence_t& s);
+  // check many sequences: sequence i is stati[offset[i]...offset[i+1]-1]
+  void prefilter_sequences(const vector<uint>& stati, const vector<size_t>& offset, vector<sequence_verdict>& result);
+
+};
+
+#endif
@@ -0,0 +1,306 @@
+#include "search.hpp"
+#include "../util/canon.hpp"
+#include "../util/flat.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+// the number of nodes a thread visits before adding them to the shared count (and checking the budget)
+#define SEARCH_COUNT_INTERVAL 1024
+// the number of words of failed states a thread remembers before it forgets them all
+#define SEARCH_DEAD_WORDS (1 << 24)
+// the first levels of the search are expanded until there are this many nodes per thread
+#define SEARCH_NODES_PER_THREAD 16
+
+namespace status {
+
+  thread_local uint64_t search_nodes = 0;
+
+  const char* get_outcome_description(const search_outcome o){
+    switch(o){
+      case TREE_FOUND: return "found a tree";
+      case NO_TREE: return "no tree has this sequence";
+      case BUDGET_EXHAUSTED: return "gave up after visiting the maximum number of nodes";
+    }
+    return "unknown outcome";
+  }
+
+  // a node of the search: the vertices before next have been attached to the tree
+  struct search_state {
+    uint next;
+    // the vertices before first_open have all vertices of their subtrees
+    uint first_open;
+    // the sum of the subtree sizes of the vertices attached so far, and the most that the others can add to it
+    uint64_t size_sum;
+    uint64_t size_bound;
+    parent_array parent;
+    // the number of vertices that the subtree of each vertex still lacks
+    vector<uint> missing;
+  };
+
+  // the most that the subtree sizes of k vertices can add up to (if they form a path)
+  inline uint64_t path_sum(const uint64_t k){ return k * (k + 1) / 2; }
+
+  // what all threads of a search share
+  struct search_shared {
+    uint n;
+    // the stati in increasing order, the root first
+    vector<uint> stati;
+    uint64_t budget;
+    // the number of nodes a thread visits before counting them
+    uint64_t count_interval;
+    atomic<uint64_t> nodes;
+    atomic<bool> stop;
+    atomic<bool> exhausted;
+    mutex result_lock;
+    parent_array result;
+
+    search_shared(const sequence_t& s, const uint64_t _budget):
+      n(get_num_vertices(s)), budget(_budget), count_interval(min((uint64_t)SEARCH_COUNT_INTERVAL, max(_budget, (uint64_t)1))), nodes(0), stop(false), exhausted(false)
+    {
+      stati.reserve(n);
+      for(const auto& entry : s) stati.insert(stati.end(), entry.second, entry.first);
+      sort(stati.begin(), stati.end());
+    }
+
+    // add the nodes a thread visited, stopping everyone once the budget is used up
+    inline void count(const uint64_t visited){
+      if(nodes.fetch_add(visited) + visited >= budget){
+        exhausted = true;
+        stop = true;
+      }
+    }
+    // the first tree found is the result
+    void found(const parent_array& parent){
+      lock_guard<mutex> guard(result_lock);
+      if(result.empty()) result = parent;
+      stop = true;
+    }
+  };
+
+  // advance first_open and check the bounds, return false if no tree can grow out of st
+  bool search_feasible(const search_shared& sh, search_state& st){
+    const uint n(sh.n);
+    // the status of the root is the sum of the distances to it, that is, the sum of all subtree sizes
+    if(st.next == n) return st.size_sum == sh.stati[0];
+    if((st.size_sum + (n - st.next) > sh.stati[0]) || (st.size_sum + st.size_bound < sh.stati[0])) return false;
+    // some vertex before next lacks vertices, since the missing vertices add up to the vertices not attached yet
+    while(!st.missing[st.first_open]) ++st.first_open;
+    // the open vertex of smallest status needs another child, whose status is at most n - 2 more than its own
+    return sh.stati[st.first_open] + n - 2 >= sh.stati[st.next];
+  }
+
+  // list the vertices that the next status can be attached to, such that the subtree of the new vertex fits into theirs
+  void search_branches(const search_shared& sh, const search_state& st, vector<uint>& result){
+    result.clear();
+    const uint j(st.next);
+    const uint z(sh.stati[j]);
+    // equal stati are attached in the order of their parents, the other orders give the same trees
+    const uint first(((j > 1) && (sh.stati[j - 1] == z)) ? max(st.first_open, st.parent[j - 1]) : st.first_open);
+    for(uint p = first; p < j; ++p){
+      const uint m(st.missing[p]);
+      if(!m) continue;
+      const uint x(sh.stati[p]);
+      // z = x + n - 2k, where k is the size of the subtree of the new vertex (search_feasible made sure that k > 0)
+      const uint twice_k(x + sh.n - z);
+      if((twice_k & 1) || (twice_k / 2 > m)) continue;
+      // attaching to a vertex of the same status with the same number of missing vertices gives the same trees
+      bool same(false);
+      for(const uint q : result)
+        if((sh.stati[q] == x) && (st.missing[q] == m)){
+          same = true;
+          break;
+        }
+      if(!same) result.push_back(p);
+    }
+  }
+
+  // attach the next vertex to p with a subtree of k vertices, and undo this
+  inline void search_attach(search_state& st, const uint p, const uint k){
+    const uint j(st.next++);
+    const uint m(st.missing[p]);
+    st.size_bound -= path_sum(m) - path_sum(m - k) - path_sum(k - 1);
+    st.size_sum += k;
+    st.missing[p] = m - k;
+    st.missing[j] = k - 1;
+    st.parent[j] = p;
+  }
+  inline void search_detach(search_state& st, const uint k){
+    const uint j(--st.next);
+    const uint p(st.parent[j]);
+    const uint m(st.missing[p] + k);
+    st.missing[p] = m;
+    st.size_sum -= k;
+    st.size_bound += path_sum(m) - path_sum(m - k) - path_sum(k - 1);
+  }
+
+  // a thread of the search, going depth-first through the nodes below the ones it is given
+  class tree_searcher {
+    search_shared& shared;
+    const uint n;
+    const vector<uint>& stati;
+    uint64_t visited;
+    // the states that failed (as key: next, size_sum and the sorted (status, missing) pairs of the open vertices)
+    unordered_set<vector<uint>, canonical_form_hasher> dead;
+    size_t dead_words;
+    // scratch space per level
+    vector<vector<uint> > keys;
+    vector<vector<uint> > branches;
+    vector<uint64_t> open;
+
+    // compute the key of the current state
+    void make_key(vector<uint>& key){
+      open.clear();
+      for(uint p = state.first_open; p < state.next; ++p)
+        if(state.missing[p]) open.push_back(((uint64_t)stati[p] << 32) | state.missing[p]);
+      sort(open.begin(), open.end());
+      key.clear();
+      key.push_back(state.next);
+      key.push_back((uint)state.size_sum);
+      key.push_back((uint)(state.size_sum >> 32));
+      for(const uint64_t x : open){
+        key.push_back(x >> 32);
+        key.push_back((uint)x);
+      }
+    }
+
+    bool search(){
+      if(shared.stop.load(memory_order_relaxed)) return false;
+      if(++visited == shared.count_interval){
+        shared.count(visited);
+        visited = 0;
+      }
+      const uint j(state.next);
+      const uint first_open(state.first_open);
+      if(!search_feasible(shared, state)){
+        state.first_open = first_open;
+        return false;
+      }
+      if(j == n) return true;
+
+      // the search below a state is complete unless it continues a run of equal stati (whose order depends on how we got
+      // here), so a state that failed before fails again
+      const bool keyed((j < 2) || (stati[j - 1] != stati[j]));
+      vector<uint>& key(keys[j]);
+      if(keyed){
+        make_key(key);
+        if(dead.count(key)){
+          state.first_open = first_open;
+          return false;
+        }
+      }
+      vector<uint>& b(branches[j]);
+      search_branches(shared, state, b);
+      for(const uint p : b){
+        const uint k((stati[p] + n - stati[j]) / 2);
+        search_attach(state, p, k);
+        if(search()) return true;
+        search_detach(state, k);
+      }
+      state.first_open = first_open;
+
+      if(keyed && !shared.stop.load(memory_order_relaxed)){
+        if(dead_words > SEARCH_DEAD_WORDS){
+          dead.clear();
+          dead_words = 0;
+        }
+        dead_words += key.size();
+        dead.insert(key);
+      }
+      return false;
+    }
+  public:
+    search_state state;
+
+    tree_searcher(search_shared& _shared):
+      shared(_shared), n(_shared.n), stati(_shared.stati), visited(0), dead_words(0), keys(n + 1), branches(n + 1) {}
+    // the search is over, so the last nodes do not exhaust the budget anymore
+    ~tree_searcher(){ shared.nodes += visited; }
+
+    // search below st, return true if a tree is found (which is then in state.parent)
+    bool search_from(search_state& st){
+      state.next = st.next;
+      state.first_open = st.first_open;
+      state.size_sum = st.size_sum;
+      state.size_bound = st.size_bound;
+      state.parent.swap(st.parent);
+      state.missing.swap(st.missing);
+      return search();
+    }
+  };
+
+  tree* stati_to_tree(const sequence_t& s, const solv_options& opts, search_outcome* const outcome, sequence_verdict* const verdict){
+    search_outcome own_outcome;
+    search_outcome& result_outcome(outcome ? *outcome : own_outcome);
+    search_nodes = 0;
+    // reject what cannot be the sequence of any tree before searching
+    const sequence_verdict v(prefilter_sequence(s));
+    if(verdict) *verdict = v;
+    result_outcome = NO_TREE;
+    if(v != SEQUENCE_OK) return NULL;
+
+    search_shared shared(s, opts.search_budget);
+    const uint n(shared.n);
+    // the root (of minimum status) lacks all other vertices
+    search_state start;
+    start.next = 1;
+    start.first_open = 0;
+    start.size_sum = 0;
+    start.size_bound = path_sum(n - 1);
+    start.parent.assign(n, NO_PARENT);
+    start.missing.assign(n, 0);
+    start.missing[0] = n - 1;
+
+    // expand the first levels breadth-first until every thread gets a few nodes (or the search is over)
+    const uint num_threads(opts.search_threads ? opts.search_threads : max(thread::hardware_concurrency(), 1U));
+    vector<search_state> frontier(1, start), next_frontier;
+    vector<uint> b;
+    bool growing(true);
+    while(growing && !shared.stop && (frontier.size() < SEARCH_NODES_PER_THREAD * num_threads)){
+      growing = false;
+      next_frontier.clear();
+      for(search_state& st : frontier){
+        if(!search_feasible(shared, st)) continue;
+        if(st.next == n){
+          next_frontier.push_back(move(st));
+          continue;
+        }
+        growing = true;
+        search_branches(shared, st, b);
+        for(const uint p : b){
+          next_frontier.push_back(st);
+          search_attach(next_frontier.back(), p, (shared.stati[p] + n - shared.stati[st.next]) / 2);
+        }
+      }
+      shared.count(frontier.size());
+      frontier.swap(next_frontier);
+    }
+
+    // each thread takes the next node of the frontier when it's done with the last
+    atomic<size_t> next_node(0);
+    auto work = [&](){
+      tree_searcher searcher(shared);
+      for(size_t i = next_node++; (i < frontier.size()) && !shared.stop; i = next_node++)
+        if(searcher.search_from(frontier[i])) shared.found(searcher.state.parent);
+    };
+    {
+      vector<thread> threads;
+      for(size_t t = 1; t < min((size_t)num_threads, frontier.size()); ++t) threads.push_back(thread(work));
+      work();
+      for(thread& th : threads) th.join();
+    }
+    search_nodes = shared.nodes;
+
+    if(!shared.result.empty()){
+      result_outcome = TREE_FOUND;
+      return parents_to_tree(shared.result);
+    }
+    if(shared.exhausted) result_outcome = BUDGET_EXHAUSTED;
+    return NULL;
+  }
+
+  uint64_t get_search_nodes(){ return search_nodes; }
+
+};
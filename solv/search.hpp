@@ -0,0 +1,40 @@
+#ifndef SEARCH_HPP
+#define SEARCH_HPP
+
+#include "../util/seq.hpp"
+#include "../util/graphs.hpp"
+#include "prefilter.hpp"
+#include "options.hpp"
+#include <stdint.h>
+
+namespace status {
+
+  // how the search for a tree ended
+  enum search_outcome { TREE_FOUND, NO_TREE, BUDGET_EXHAUSTED };
+
+  const char* get_outcome_description(const search_outcome o);
+
+  // reconstruct any tree (not only a caterpillar) from a status sequence by branch and bound (the caller owns the result)
+  //
+  // rooted at a vertex of minimum status (a centroid), a vertex v with k vertices in its subtree has status
+  // s(v) = s(p) + n - 2k, where p is its parent (see get_adjacent_status), so the stati grow from the root outwards and
+  // the status of a vertex and its parent tell the size of its subtree; the tree is grown from the root by taking the stati
+  // in increasing order and attaching each to a vertex that still lacks at least that many vertices in its subtree; the
+  // status of the root must then be the sum of all subtree sizes (its distances to all vertices)
+  // a branch is cut if the open vertex of smallest status cannot get any more children (all of them would have status at
+  // most its status + n - 2), if the sum of subtree sizes cannot reach the status of the root anymore, or if the open
+  // vertices (as multiset of status and missing vertices) are those of a state that failed before; of several open
+  // vertices with equal status and equal number of missing vertices, only the first is tried
+  //
+  // the first levels of the search are split among opts.search_threads threads, which stop as soon as one of them finds a
+  // tree or when they visited opts.search_budget nodes together; the outcome is written to outcome (if given) and
+  // sequences rejected by the pre-filter are not searched (the reason is written to verdict, if given)
+  tree* stati_to_tree(const sequence_t& s, const solv_options& opts = solv_options(), search_outcome* const outcome = NULL,
+                      sequence_verdict* const verdict = NULL);
+
+  // the number of nodes visited by the last call to stati_to_tree (in all threads)
+  uint64_t get_search_nodes();
+
+};
+
+#endif
@@ -0,0 +1,286 @@
+#include "server.hpp"
+#include "caterpillar.hpp"
+#include "../util/timer.hpp"
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace status {
+
+  // a connection with buffered input and output; the output is flushed whenever we would wait for input, so pipelined
+  // requests get their replies in few writes
+  class connection {
+    const int in, out;
+    vector<char> in_buffer;
+    size_t in_begin, in_end;
+    string out_buffer;
+
+    // refill the input buffer, return false at the end of the input
+    bool fill(){
+      flush();
+      if(in_begin == in_end) in_begin = in_end = 0;
+      if(in_end == in_buffer.size()) in_buffer.resize(2 * in_buffer.size());
+      ssize_t r;
+      do r = read(in, in_buffer.data() + in_end, in_buffer.size() - in_end); while((r < 0) && (errno == EINTR));
+      if(r <= 0) return false;
+      in_end += r;
+      return true;
+    }
+  public:
+    connection(const int _in, const int _out): in(_in), out(_out), in_buffer(1 << 16), in_begin(0), in_end(0) {}
+
+    // read a line (without the newline), return false at the end of the input
+    bool read_line(string& line){
+      line.clear();
+      while(true){
+        char* const begin(in_buffer.data() + in_begin);
+        char* const newline((char*)memchr(begin, '\n', in_end - in_begin));
+        if(newline){
+          line.append(begin, newline - begin);
+          in_begin += newline - begin + 1;
+          return true;
+        }
+        line.append(begin, in_end - in_begin);
+        in_begin = in_end;
+        if(!fill()) return !line.empty();
+      }
+    }
+    // read exactly bytes bytes, return false at the end of the input
+    bool read_bytes(void* const target, const size_t bytes){
+      for(size_t done = 0; done < bytes;){
+        if(in_begin == in_end) if(!fill()) return false;
+        const size_t chunk(min(bytes - done, in_end - in_begin));
+        memcpy((char*)target + done, in_buffer.data() + in_begin, chunk);
+        in_begin += chunk;
+        done += chunk;
+      }
+      return true;
+    }
+    inline void write_bytes(const void* const source, const size_t bytes){ out_buffer.append((const char*)source, bytes); }
+    inline void write_string(const string& s){ out_buffer.append(s); }
+
+    void flush(){
+      for(size_t done = 0; done < out_buffer.size();){
+        const ssize_t w(write(out, out_buffer.data() + done, out_buffer.size() - done));
+        if(w < 0){
+          if(errno == EINTR) continue;
+          // the client is gone, forget the rest
+          break;
+        }
+        done += w;
+      }
+      out_buffer.clear();
+    }
+  };
+
+  // the state of a worker thread, reused for all its requests
+  struct server_worker {
+    const server_options* opts;
+    sequence_t seq;
+    sequence_entries_t entries;
+    // the number of vertices of seq (which may be too many to count in a uint)
+    uint64_t num_vertices;
+    vector<uint> backbone, leaves;
+    string line, reply;
+    vector<uint> request;
+    // the latencies, locked since stats requests read the latencies of all workers
+    latency_histogram latency;
+    mutex latency_lock;
+  };
+
+  // all workers, for the stats
+  vector<server_worker*> server_workers;
+  mutex server_workers_lock;
+  // the listening socket (if any), so that the signal handler can stop accepting
+  volatile int server_socket(-1);
+
+  // solve the request in w.seq, return the length of the backbone written to w.leaves (or 0 and the verdict)
+  uint answer(server_worker& w, sequence_verdict& verdict){
+    tree* const result(stati_to_caterpillar(w.seq, w.opts->solver, &verdict));
+    if(!result) return 0;
+    const uint n(result->get_size());
+    if(w.backbone.size() < n){
+      w.backbone.resize(n);
+      w.leaves.resize(n);
+    }
+    const uint length(recognize_caterpillar(*result, w.backbone.data(), w.leaves.data()));
+    assert(length != NOT_A_CATERPILLAR);
+    result->clear();
+    delete result;
+    return length;
+  }
+
+  // collect the latencies of all workers
+  latency_histogram merged_latencies(){
+    latency_histogram result;
+    lock_guard<mutex> guard(server_workers_lock);
+    for(server_worker* w : server_workers){
+      lock_guard<mutex> worker_guard(w->latency_lock);
+      result.merge(w->latency);
+    }
+    return result;
+  }
+
+  inline void record_latency(server_worker& w, const chrono::steady_clock::time_point& start){
+    const uint64_t ns(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+    lock_guard<mutex> guard(w.latency_lock);
+    w.latency.add(ns);
+  }
+
+  // parse a line "1x38 5x32 ..." into w.seq like a line of a sequence file, return what we found (see
+  // parse_sequence_line) and set error if it is malformed
+  line_result parse_request(server_worker& w, const char*& error){
+    const line_result result(parse_sequence_line(w.line.data(), w.line.data() + w.line.size(), w.entries, error));
+    w.seq.clear();
+    w.num_vertices = 0;
+    for(const auto& entry : w.entries){
+      w.seq[entry.first] += entry.second;
+      w.num_vertices += entry.second;
+    }
+    return result;
+  }
+
+  void serve_lines(server_worker& w, connection& c){
+    while(c.read_line(w.line)){
+      if(w.line == "stats"){
+        const latency_histogram h(merged_latencies());
+        c.write_string("stats " + to_string(h.size()) + ' ' + to_string(h.percentile(0.5)) + ' ' + to_string(h.percentile(0.99)) + '\n');
+        continue;
+      }
+      const chrono::steady_clock::time_point start(chrono::steady_clock::now());
+      const char* error;
+      const line_result parsed(parse_request(w, error));
+      if(parsed == LINE_EMPTY) continue;
+      if(parsed == LINE_MALFORMED){
+        ((w.reply = "error ") += error) += '\n';
+        c.write_string(w.reply);
+        continue;
+      }
+      sequence_verdict verdict(TOO_MANY_VERTICES);
+      const uint length((w.num_vertices > w.opts->max_vertices) ? 0 : answer(w, verdict));
+      if(length){
+        w.reply = "ok";
+        for(uint i = 0; i < length; ++i) (w.reply += ' ') += to_string(w.leaves[i]);
+      } else if(verdict != SEQUENCE_OK) w.reply = "reject " + to_string((uint)verdict);
+      else w.reply = "none";
+      w.reply += '\n';
+      c.write_string(w.reply);
+      record_latency(w, start);
+    }
+  }
+
+  void serve_binary(server_worker& w, connection& c){
+    uint32_t k;
+    while(c.read_bytes(&k, sizeof(k))){
+      if(k == UINT32_MAX){
+        const latency_histogram h(merged_latencies());
+        const uint64_t stats[3] = { h.size(), h.percentile(0.5), h.percentile(0.99) };
+        c.write_bytes(stats, sizeof(stats));
+        continue;
+      }
+      // each pair with a multiplicity adds vertices, so more pairs than max_vertices are nonsense that we would have to
+      // read before the next request
+      if(k > w.opts->max_vertices) break;
+      w.request.resize(2 * (size_t)k);
+      if(!c.read_bytes(w.request.data(), 2 * (size_t)k * sizeof(uint32_t))) break;
+      const chrono::steady_clock::time_point start(chrono::steady_clock::now());
+      w.seq.clear();
+      w.num_vertices = 0;
+      for(size_t i = 0; i < k; ++i)
+        if(w.request[2 * i]){
+          w.seq[w.request[2 * i + 1]] += w.request[2 * i];
+          w.num_vertices += w.request[2 * i];
+        }
+      sequence_verdict verdict(w.seq.empty() ? EMPTY_SEQUENCE : TOO_MANY_VERTICES);
+      const uint32_t length((w.seq.empty() || (w.num_vertices > w.opts->max_vertices)) ? 0 : answer(w, verdict));
+      c.write_bytes(&length, sizeof(length));
+      if(length) c.write_bytes(w.leaves.data(), length * sizeof(uint32_t)); else {
+        const uint32_t v(verdict);
+        c.write_bytes(&v, sizeof(v));
+      }
+      record_latency(w, start);
+    }
+  }
+
+  void serve_connection(server_worker& w, const int in, const int out){
+    connection c(in, out);
+    if(w.opts->binary) serve_binary(w, c); else serve_lines(w, c);
+    c.flush();
+  }
+
+  void* server_thread(void* arg){
+    server_worker& w(*(server_worker*)arg);
+    if(w.opts->socket_path == "-"){
+      serve_connection(w, 0, 1);
+      return NULL;
+    }
+    while(true){
+      const int fd(accept(server_socket, NULL, NULL));
+      if(fd < 0){
+        if(errno == EINTR) continue;
+        // the socket was shut down
+        return NULL;
+      }
+      serve_connection(w, fd, fd);
+      close(fd);
+    }
+  }
+
+  void stop_serving(int){
+    if(server_socket >= 0) shutdown(server_socket, SHUT_RDWR);
+  }
+
+  void serve(const server_options& opts){
+    const bool on_socket(opts.socket_path != "-");
+    if(on_socket){
+      sockaddr_un address;
+      memset(&address, 0, sizeof(address));
+      address.sun_family = AF_UNIX;
+      if(opts.socket_path.size() >= sizeof(address.sun_path)) FAIL("socket path "<<opts.socket_path<<" is too long");
+      strcpy(address.sun_path, opts.socket_path.c_str());
+      const int fd(socket(AF_UNIX, SOCK_STREAM, 0));
+      if(fd < 0) FAIL("unable to create a socket");
+      unlink(opts.socket_path.c_str());
+      if(bind(fd, (sockaddr*)&address, sizeof(address)) || listen(fd, 128)) FAIL("unable to listen on "<<opts.socket_path);
+      server_socket = fd;
+      signal(SIGINT, stop_serving);
+      signal(SIGTERM, stop_serving);
+    }
+    // a client that hangs up should not take the server with it
+    signal(SIGPIPE, SIG_IGN);
+
+    // stdin/stdout is a single connection, so it gets a single worker
+    const uint num_threads(on_socket ? max(1U, opts.threads) : 1);
+    vector<server_worker> workers(num_threads);
+    for(server_worker& w : workers){
+      w.opts = &opts;
+      server_workers.push_back(&w);
+    }
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if(pthread_attr_setstacksize(&attr, (size_t)opts.stack_mb << 20)) FAIL("cannot set stack size");
+    vector<pthread_t> threads(num_threads);
+    for(uint i = 0; i < num_threads; ++i)
+      if(pthread_create(&threads[i], &attr, server_thread, &workers[i])) FAIL("cannot create server thread");
+    for(pthread_t& t : threads) pthread_join(t, NULL);
+    pthread_attr_destroy(&attr);
+
+    if(on_socket){
+      close(server_socket);
+      server_socket = -1;
+      unlink(opts.socket_path.c_str());
+    }
+    const latency_histogram h(merged_latencies());
+    cerr << "served " << h.size() << " requests, latency p50 " << h.percentile(0.5) << "ns, p99 " << h.percentile(0.99) << "ns" << endl;
+    server_workers.clear();
+  }
+
+};
@@ -0,0 +1,49 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include "options.hpp"
+#include "../util/defs.hpp"
+#include <string>
+
+using namespace std;
+
+namespace status {
+
+  // a server answers reconstruction requests on stdin/stdout or on a Unix domain socket, without writing any files;
+  // each worker thread keeps its solver state (see stati_to_caterpillar) and buffers between requests
+  //
+  // line protocol: a request is a line of a sequence file ("1x38 5x32 ...", see sequence_reader, empty lines are
+  // skipped without a reply), the reply is
+  //   "ok l_1 ... l_k"  - a caterpillar whose backbone vertices have l_1, ..., l_k leaves (see recognize_caterpillar)
+  //   "none"            - the sequence passed the pre-filter but no caterpillar has it
+  //   "reject <code>"   - the pre-filter rejected the sequence (see sequence_verdict), or it has more than max_vertices
+  //                       vertices (TOO_MANY_VERTICES)
+  //   "error <text>"    - the request could not be parsed, the text says why
+  // the request "stats" is answered by "stats <#requests> <p50> <p99>", the latencies being in nanoseconds
+  //
+  // binary protocol (native byte order): a request is a uint32 k followed by k pairs of uint32 (multiplicity, status),
+  // the reply is a uint32 k followed by k uint32 numbers of leaves, or a 0 followed by a uint32 sequence_verdict
+  // (SEQUENCE_OK if no caterpillar has the sequence); the request k = UINT32_MAX is answered by 3 uint64 numbers:
+  // #requests, p50 and p99; a request with more than max_vertices pairs closes the connection
+  struct server_options {
+    // the socket to listen on, or "-" for stdin/stdout
+    string socket_path;
+    bool binary;
+    // number of worker threads (each serving one connection at a time)
+    uint threads;
+    // stack size of the worker threads in MB, the solver recurses along the backbone
+    uint stack_mb;
+    // the most vertices a request may have, larger requests are rejected before anything is allocated for them
+    uint max_vertices;
+    solv_options solver;
+
+    server_options(): socket_path("-"), binary(false), threads(1), stack_mb(1024), max_vertices(1 << 16) {}
+  };
+
+  // serve until stdin is closed or, for a socket, until SIGINT or SIGTERM (open connections are finished first);
+  // then the number of requests and the latency percentiles are written to stderr
+  void serve(const server_options& opts);
+
+};
+
+#endif
@@ -0,0 +1,378 @@
+
+#include "../util/graphs.hpp"
+#include "../util/seq.hpp"
+#include "../util/tree_view.hpp"
+#include "../util/generate.hpp"
+#include "../solv/caterpillar.hpp"
+#include <chrono>
+#include <vector>
+#include <algorithm> // for sort()
+#include <cmath>
+#include <iomanip>
+#include <pthread.h>
+
+// benchmark harness: times the library functions on a sweep of generated trees, reports median and median absolute
+// deviation of the repetitions and compares them against a baseline file written by a previous run
+
+typedef std::chrono::steady_clock bench_clock;
+
+// the result of a benchmark on one instance
+struct measurement {
+  string bench;
+  string gen;
+  size_t n;
+  double median;
+  double mad;
+};
+
+struct generator_entry {
+  const char* name;
+  status::tree* (*generate)(const size_t, const uint64_t);
+  bool is_caterpillar;
+};
+
+const generator_entry generators[] = {
+  { "rtree",  status::get_random_tree,               false },
+  { "rcat",   status::get_random_caterpillar,        true },
+  { "rcats",  status::get_random_sparse_caterpillar, true },
+};
+
+const std::pair<string, int> _requires_params[] = {
+  { "min", 1 },
+  { "max", 1 },
+  { "solver_max", 1 },
+  { "reps", 1 },
+  { "seed", 1 },
+  { "baseline", 1 },
+  { "save", 0 },
+  { "stack", 1 },
+};
+std::map<string, std::vector<string> > arguments;
+
+void usage(const char* progname, std::ostream& o){
+  o << "usage: " << progname << " [opts]" << std::endl;
+  o << "opts:  min <exp>\t\t- smallest instance has 10^exp vertices (default 3)" << std::endl;
+  o << "       max <exp>\t\t- largest instance has 10^exp vertices (default 7)" << std::endl;
+  o << "       solver_max <#vertices>\t- largest instance for stati_to_caterpillar, doubling from 100 (default 400)" << std::endl;
+  o << "       reps <#>\t\t- repetitions per measurement (default 5)" << std::endl;
+  o << "       seed <#>\t\t- seed of the generators (default 1)" << std::endl;
+  o << "       baseline <file>\t- compare against (or save to) this file (default bench.baseline)" << std::endl;
+  o << "       save\t\t- write the results as new baseline" << std::endl;
+  o << "       stack <MB>\t- stack size of the benchmark thread, the recursions go as deep as the trees (default 4096)" << std::endl;
+  exit(1);
+}
+
+void parse_args(int argc, char** argv){
+  std::map<std::string, int>  requires_params(std::begin(_requires_params), std::end(_requires_params));
+  int arg_ptr = 1;
+  while(arg_ptr < argc){
+    const std::string arg(argv[arg_ptr++]);
+    if(requires_params.find(arg) == requires_params.end()) usage(argv[0], std::cerr);
+    if(argc < arg_ptr + requires_params[arg]) usage(argv[0], std::cerr);
+    std::vector<string> params(requires_params[arg]);
+    for(int i = 0; i < requires_params[arg]; ++i)
+      params[i] = argv[arg_ptr++];
+    arguments.insert(make_pair(arg, params));
+  }
+}
+
+// get a numeric argument or its default
+inline size_t get_arg(const string& name, const size_t dflt){
+  return (arguments.find(name) != arguments.end()) ? atoll(arguments[name][0].c_str()) : dflt;
+}
+
+inline double seconds_since(const bench_clock::time_point& start){
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+// median of the given values (reorders them)
+double median(std::vector<double>& v){
+  std::sort(v.begin(), v.end());
+  const size_t m(v.size() >> 1);
+  return (v.size() & 1) ? v[m] : (v[m - 1] + v[m]) / 2;
+}
+
+// run f (which returns the seconds it measured) reps times and compute median and median absolute deviation
+template<class F>
+measurement measure(const string& bench, const string& gen, const size_t n, const uint reps, F f){
+  std::vector<double> times;
+  for(uint i = 0; i < reps; ++i) times.push_back(f());
+  measurement m;
+  m.bench = bench;
+  m.gen = gen;
+  m.n = n;
+  m.median = median(times);
+  for(double& x : times) x = fabs(x - m.median);
+  m.mad = median(times);
+  return m;
+}
+
+// delete a tree with all its vertices
+inline void delete_tree(status::tree* t){
+  t->clear();
+  delete t;
+}
+
+// benchmark the library functions on one instance
+void bench_library(const generator_entry& g, const size_t n, const uint reps, const uint64_t seed, std::vector<measurement>& results){
+  status::tree* t = g.generate(n, seed);
+  status::sequence_t s;
+  const string tmp_file(".bench.tree");
+
+  results.push_back(measure("compute_stati", g.name, n, reps, [&]()->double{
+    const bench_clock::time_point start(bench_clock::now());
+    s = status::compute_stati(*t);
+    return seconds_since(start);
+  }));
+
+  status::stati_result kernel_result;
+  results.push_back(measure("stati_kernel_all", g.name, n, reps, [&]()->double{
+    const bench_clock::time_point start(bench_clock::now());
+    status::compute_stati<status::STATUS | status::SUBTREE_SIZE | status::DEPTH | status::ECCENTRICITY
+                          | status::WIENER_INDEX | status::HISTOGRAM>(status::pointer_tree_view(*t), kernel_result);
+    return seconds_since(start);
+  }));
+
+  std::vector<uint> stati(t->get_size());
+  results.push_back(measure("compute_stati_array", g.name, n, reps, [&]()->double{
+    const bench_clock::time_point start(bench_clock::now());
+    status::compute_stati(*t, stati.data());
+    return seconds_since(start);
+  }));
+
+  status::vertex* median_vertex(NULL);
+  results.push_back(measure("compute_median", g.name, n, reps, [&]()->double{
+    const bench_clock::time_point start(bench_clock::now());
+    median_vertex = status::compute_median(*t, stati.data());
+    return seconds_since(start);
+  }));
+
+  // the same on views of the tree (see tree_view.hpp), the parent array is in BFS order
+  status::parent_array parent;
+  status::tree_to_parents(*t, parent);
+  results.push_back(measure("compute_stati_parents", g.name, n, reps, [&]()->double{
+    const bench_clock::time_point start(bench_clock::now());
+    status::compute_stati(status::parent_array_view(parent), stati.data());
+    return seconds_since(start);
+  }));
+
+  results.push_back(measure("compute_stati_view", g.name, n, reps, [&]()->double{
+    const bench_clock::time_point start(bench_clock::now());
+    status::compute_stati(status::pointer_tree_view(*t), stati.data());
+    return seconds_since(start);
+  }));
+
+  results.push_back(measure("compute_centroid", g.name, n, reps, [&]()->double{
+    const bench_clock::time_point start(bench_clock::now());
+    median_vertex = status::compute_centroid(*t);
+    return seconds_since(start);
+  }));
+
+  status::vertex* const old_root(t->get_root());
+  results.push_back(measure("reroot", g.name, n, reps, [&]()->double{
+    const bench_clock::time_point start(bench_clock::now());
+    t->reroot(median_vertex);
+    const double d(seconds_since(start));
+    t->reroot(old_root);
+    return d;
+  }));
+
+  results.push_back(measure("copy_tree_preserving", g.name, n, reps, [&]()->double{
+    status::vertex_translator translator;
+    const bench_clock::time_point start(bench_clock::now());
+    status::tree* copy = status::copy_tree_preserving(*t, translator);
+    const double d(seconds_since(start));
+    delete_tree(copy);
+    return d;
+  }));
+
+  results.push_back(measure("write_to_file", g.name, n, reps, [&]()->double{
+    const bench_clock::time_point start(bench_clock::now());
+    t->write_to_file(tmp_file);
+    return seconds_since(start);
+  }));
+
+  results.push_back(measure("read_from_file", g.name, n, reps, [&]()->double{
+    status::tree u;
+    const bench_clock::time_point start(bench_clock::now());
+    u.read_from_file(tmp_file);
+    const double d(seconds_since(start));
+    u.clear_vertices();
+    return d;
+  }));
+  remove(tmp_file.c_str());
+
+  results.push_back(measure("detect_caterpillar", g.name, n, reps, [&]()->double{
+    const bench_clock::time_point start(bench_clock::now());
+    status::detect_caterpillar(*t);
+    return seconds_since(start);
+  }));
+
+  results.push_back(measure("detect_caterpillar_parents", g.name, n, reps, [&]()->double{
+    const bench_clock::time_point start(bench_clock::now());
+    status::detect_caterpillar(status::parent_array_view(parent));
+    return seconds_since(start);
+  }));
+
+  std::vector<uint> backbone(n), leaves(n);
+  results.push_back(measure("recognize_caterpillar", g.name, n, reps, [&]()->double{
+    const bench_clock::time_point start(bench_clock::now());
+    status::recognize_caterpillar(*t, backbone.data(), leaves.data());
+    return seconds_since(start);
+  }));
+
+  delete_tree(t);
+}
+
+// benchmark the solver on the sequence of one instance
+void bench_solver(const generator_entry& g, const size_t n, const uint reps, const uint64_t seed, std::vector<measurement>& results){
+  status::tree* t = g.generate(n, seed);
+  const status::sequence_t s(status::compute_stati(*t));
+  delete_tree(t);
+
+  std::vector<uint> sorted;
+  for(const auto& entry : s) sorted.insert(sorted.end(), entry.second, entry.first);
+  std::sort(sorted.begin(), sorted.end());
+  results.push_back(measure("prefilter_sequence", g.name, n, reps, [&]()->double{
+    const bench_clock::time_point start(bench_clock::now());
+    const status::sequence_verdict v(status::prefilter_sequence(sorted.data(), sorted.size()));
+    const double d(seconds_since(start));
+    if(v != status::SEQUENCE_OK) cerr << "prefilter_sequence rejected "<<g.name<<" with "<<n<<" vertices" << endl;
+    return d;
+  }));
+
+  results.push_back(measure("stati_to_caterpillar", g.name, n, reps, [&]()->double{
+    const bench_clock::time_point start(bench_clock::now());
+    status::tree* r = status::stati_to_caterpillar(s);
+    const double d(seconds_since(start));
+    if(r) delete_tree(r); else cerr << "stati_to_caterpillar failed on "<<g.name<<" with "<<n<<" vertices" << endl;
+    return d;
+  }));
+
+  status::solv_options all;
+  all.first_solution = false;
+  results.push_back(measure("stati_to_caterpillar_all", g.name, n, reps, [&]()->double{
+    const bench_clock::time_point start(bench_clock::now());
+    status::tree* r = status::stati_to_caterpillar(s, all);
+    const double d(seconds_since(start));
+    if(r) delete_tree(r); else cerr << "stati_to_caterpillar failed on "<<g.name<<" with "<<n<<" vertices" << endl;
+    return d;
+  }));
+  cerr << "  the exhaustive solver tabled " << status::get_table_size() << " inputs" << endl;
+
+  // answer the sequence from a warm cache
+  const string cache_file(".bench.cache");
+  {
+    status::reconstruction_cache cache(cache_file, 1 << 20);
+    status::solv_options cached;
+    cached.cache = &cache;
+    status::tree* const warm(status::stati_to_caterpillar(s, cached));
+    if(warm) delete_tree(warm);
+    results.push_back(measure("stati_to_caterpillar_cached", g.name, n, reps, [&]()->double{
+      const bench_clock::time_point start(bench_clock::now());
+      status::tree* r = status::stati_to_caterpillar(s, cached);
+      const double d(seconds_since(start));
+      if(r) delete_tree(r); else cerr << "stati_to_caterpillar failed on "<<g.name<<" with "<<n<<" vertices" << endl;
+      return d;
+    }));
+  }
+  remove(cache_file.c_str());
+}
+
+// read a baseline file
+std::map<string, measurement> read_baseline(const string& filename){
+  std::map<string, measurement> result;
+  ifstream f(filename);
+  measurement m;
+  while(f >> m.bench >> m.gen >> m.n >> m.median >> m.mad)
+    result[m.bench + ' ' + m.gen + ' ' + to_string(m.n)] = m;
+  return result;
+}
+
+void write_baseline(const string& filename, const std::vector<measurement>& results){
+  ofstream f(filename);
+  if(!f) FAIL("unable to open "<<filename<<" for writing");
+  f << setprecision(9);
+  for(const measurement& m : results)
+    f << m.bench << ' ' << m.gen << ' ' << m.n << ' ' << m.median << ' ' << m.mad << '\n';
+  f.close();
+  if(!f) FAIL("could not write "<<filename);
+}
+
+// a change is significant if it exceeds 3 MADs of both runs and 5% of the baseline
+inline bool significant(const measurement& m, const measurement& base){
+  const double noise(3 * max(m.mad, base.mad));
+  return (fabs(m.median - base.median) > noise) && (fabs(m.median - base.median) > 0.05 * base.median);
+}
+
+// print the results and return the number of regressions against the baseline
+uint report(std::ostream& os, const std::vector<measurement>& results, const std::map<string, measurement>& baseline){
+  uint regressions = 0;
+  os << left << setw(28) << "benchmark" << setw(7) << "gen" << right << setw(10) << "n"
+     << setw(14) << "median[s]" << setw(14) << "mad[s]" << setw(14) << "baseline[s]" << setw(10) << "change" << endl;
+  for(const measurement& m : results){
+    os << left << setw(28) << m.bench << setw(7) << m.gen << right << setw(10) << m.n
+       << setw(14) << scientific << setprecision(3) << m.median << setw(14) << m.mad;
+    const auto base(baseline.find(m.bench + ' ' + m.gen + ' ' + to_string(m.n)));
+    if(base != baseline.end()){
+      const double change(base->second.median > 0 ? 100 * (m.median - base->second.median) / base->second.median : 0);
+      os << setw(14) << base->second.median << setw(9) << fixed << setprecision(1) << showpos << change << '%' << noshowpos;
+      if(significant(m, base->second)){
+        if(m.median > base->second.median){
+          os << "  REGRESSION";
+          ++regressions;
+        } else os << "  improved";
+      }
+    }
+    os << endl;
+  }
+  return regressions;
+}
+
+uint regressions(0);
+
+void* run_benchmarks(void*){
+  const uint min_exp(get_arg("min", 3));
+  const uint max_exp(get_arg("max", 7));
+  const size_t solver_max(get_arg("solver_max", 400));
+  const uint reps(get_arg("reps", 5));
+  const uint64_t seed(get_arg("seed", 1));
+  const string baseline_file((arguments.find("baseline") != arguments.end()) ? arguments["baseline"][0] : "bench.baseline");
+
+  std::vector<measurement> results;
+  for(const generator_entry& g : generators){
+    size_t n = 1;
+    for(uint i = 0; i < min_exp; ++i) n *= 10;
+    for(uint e = min_exp; e <= max_exp; ++e, n *= 10){
+      cerr << "benchmarking " << g.name << " with " << n << " vertices" << endl;
+      bench_library(g, n, reps, seed, results);
+    }
+    // the solver is much more than linear, so it gets its own, smaller sweep
+    if(g.is_caterpillar)
+      for(size_t m = 100; m <= solver_max; m *= 2){
+        cerr << "benchmarking the solver on " << g.name << " with " << m << " vertices" << endl;
+        bench_solver(g, m, reps, seed, results);
+      }
+  }
+
+  regressions = report(cout, results, read_baseline(baseline_file));
+  if(arguments.find("save") != arguments.end()){
+    write_baseline(baseline_file, results);
+    cout << "saved baseline to " << baseline_file << endl;
+  }
+  return NULL;
+}
+
+int main(int argc, char** argv){
+  parse_args(argc, argv);
+
+  // most of the library recurses along the tree, so give it a stack that fits our deepest trees
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  if(pthread_attr_setstacksize(&attr, get_arg("stack", 4096) << 20)) FAIL("cannot set stack size");
+  pthread_t thread;
+  if(pthread_create(&thread, &attr, run_benchmarks, NULL)) FAIL("cannot create benchmark thread");
+  pthread_join(thread, NULL);
+
+  return regressions ? 1 : 0;
+}
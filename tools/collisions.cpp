@@ -0,0 +1,342 @@
+
+#include "../util/enumerate.hpp"
+#include "../util/random.hpp"
+#include "../util/tree_view.hpp"
+#include <vector>
+#include <algorithm> // for sort()
+#include <mutex>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+
+// exhaustive search for non-isomorphic trees with the same status sequence:
+// 1. enumerate all free trees with n vertices, compute their sorted status sequences and append (hash of the sequence, code
+//    of the tree) to one of several shard files on disk, chosen by the hash
+// 2. sort each shard by hash, recompute the sequences of trees with equal hashes and report the groups of trees whose
+//    sequences are really equal
+// the enumeration proceeds in epochs, after each of which all shards are flushed and a checkpoint is written to the
+// working directory, so an interrupted search continues where it left off (the same holds for the shards of phase 2)
+
+using namespace status;
+
+// a tree and the hash of its status sequence, as stored in the shards
+struct shard_record {
+  uint64_t hash;
+  uint64_t code;
+
+  bool operator<(const shard_record& r) const { return (hash < r.hash) || ((hash == r.hash) && (code < r.code)); }
+};
+
+const std::pair<string, int> _requires_params[] = {
+  { "threads", 1 },
+  { "shards", 1 },
+  { "epoch", 1 },
+  { "dir", 1 },
+  { "out", 1 },
+};
+std::map<string, std::vector<string> > arguments;
+
+void usage(const char* progname, std::ostream& o){
+  o << "usage: " << progname << " <#vertices> [opts]" << std::endl;
+  o << "opts:  threads <#>\t- number of worker threads (default: all cores)" << std::endl;
+  o << "       shards <exp>\t- use 2^exp shard files (default 8)" << std::endl;
+  o << "       epoch <exp>\t- checkpoint every 2^exp trees (default 22)" << std::endl;
+  o << "       dir <dir>\t- working directory for shards and checkpoints (default collisions.<#vertices>)" << std::endl;
+  o << "       out <file>\t- write the groups of trees with equal sequences to this file (default <dir>/groups)" << std::endl;
+  exit(1);
+}
+
+void parse_args(int argc, char** argv){
+  std::map<std::string, int>  requires_params(std::begin(_requires_params), std::end(_requires_params));
+  if(argc < 2) usage(argv[0], std::cerr);
+  int arg_ptr = 2;
+  while(arg_ptr < argc){
+    const std::string arg(argv[arg_ptr++]);
+    if(requires_params.find(arg) == requires_params.end()) usage(argv[0], std::cerr);
+    if(argc < arg_ptr + requires_params[arg]) usage(argv[0], std::cerr);
+    std::vector<string> params(requires_params[arg]);
+    for(int i = 0; i < requires_params[arg]; ++i)
+      params[i] = argv[arg_ptr++];
+    arguments.insert(make_pair(arg, params));
+  }
+}
+
+// get a numeric argument or its default
+inline size_t get_arg(const string& name, const size_t dflt){
+  return (arguments.find(name) != arguments.end()) ? atoll(arguments[name][0].c_str()) : dflt;
+}
+inline string get_string_arg(const string& name, const string& dflt){
+  return (arguments.find(name) != arguments.end()) ? arguments[name][0] : dflt;
+}
+
+// scratch space to compute sorted status sequences of level sequences without allocating
+class sequence_scratch {
+  parent_array parent;
+public:
+  vector<uint> stati;
+
+  // compute the sorted status sequence of the tree into stati
+  void compute(const level_sequence& level){
+    levels_to_parents(level, parent);
+    stati.resize(parent.size());
+    compute_stati(parent_array_view(parent), stati.data());
+    sort(stati.begin(), stati.end());
+  }
+
+  uint64_t hash() const {
+    uint64_t h(stati.size());
+    for(const uint s : stati) h = mix64(h ^ s) + s;
+    return h;
+  }
+};
+
+// the state of phase 1 in the working directory: the number of trees done and the size of each shard file after them
+struct checkpoint {
+  uint n;
+  uint shard_bits;
+  size_t trees_done;
+  vector<size_t> shard_size;
+
+  bool read(const string& filename){
+    ifstream f(filename);
+    if(!f) return false;
+    size_t num_shards;
+    f >> n >> shard_bits >> trees_done >> num_shards;
+    shard_size.resize(num_shards);
+    for(size_t& s : shard_size) f >> s;
+    return (bool)f;
+  }
+
+  // write to a temporary file and rename it, so we never see half a checkpoint
+  void write(const string& filename) const {
+    {
+      ofstream f(filename + ".tmp");
+      f << n << ' ' << shard_bits << ' ' << trees_done << ' ' << shard_size.size() << endl;
+      for(const size_t s : shard_size) f << s << endl;
+      if(!f) FAIL("could not write checkpoint "<<filename);
+    }
+    if(rename((filename + ".tmp").c_str(), filename.c_str())) FAIL("could not write checkpoint "<<filename);
+  }
+};
+
+class shard_files {
+  vector<FILE*> files;
+  vector<std::mutex> locks;
+public:
+  const uint bits;
+
+  shard_files(const string& dir, const uint _bits, const vector<size_t>& sizes): files(sizes.size()), locks(sizes.size()), bits(_bits) {
+    for(size_t k = 0; k < files.size(); ++k){
+      const string name(dir + "/shard." + to_string(k));
+      // forget whatever was written after the last checkpoint
+      if((truncate(name.c_str(), sizes[k]) != 0) && sizes[k]) FAIL("could not truncate "<<name);
+      if(!(files[k] = fopen(name.c_str(), "ab"))) FAIL("could not open "<<name);
+    }
+  }
+  ~shard_files(){ for(FILE* f : files) fclose(f); }
+
+  inline uint shard_of(const uint64_t hash) const { return bits ? hash >> (64 - bits) : 0; }
+  inline size_t size() const { return files.size(); }
+
+  void append(const uint k, const vector<shard_record>& records){
+    std::lock_guard<std::mutex> guard(locks[k]);
+    if(fwrite(records.data(), sizeof(shard_record), records.size(), files[k]) != records.size()) FAIL("could not write shard "<<k);
+  }
+
+  // flush all files and return their sizes
+  void sync(vector<size_t>& sizes){
+    for(size_t k = 0; k < files.size(); ++k){
+      std::lock_guard<std::mutex> guard(locks[k]);
+      if(fflush(files[k]) || fsync(fileno(files[k]))) FAIL("could not flush shard "<<k);
+      sizes[k] = ftell(files[k]);
+    }
+  }
+};
+
+// the enumeration is shared by the workers, each of which takes the next chunk of trees when it's done with the last
+const size_t chunk_size(1 << 12);
+const size_t shard_buffer_size(1 << 12);
+
+class tree_source {
+  std::mutex lock;
+  free_tree_enumerator trees;
+  size_t next_tree;
+  size_t end_tree;
+public:
+  tree_source(const uint n, const size_t skip): trees(n), next_tree(0), end_tree(0) {
+    // skip the trees that were done before the checkpoint, generating them is much faster than processing them
+    for(; (next_tree < skip) && trees.valid(); ++next_tree) trees.next();
+  }
+
+  inline bool valid() const { return trees.valid(); }
+  inline size_t position() const { return next_tree; }
+  inline void set_end(const size_t end) { end_tree = end; }
+
+  // get the next chunk of trees (at most until the end of the epoch) as codes, return false if there is none
+  bool get_chunk(vector<uint64_t>& codes){
+    std::lock_guard<std::mutex> guard(lock);
+    codes.clear();
+    for(; (codes.size() < chunk_size) && (next_tree < end_tree) && trees.valid(); ++next_tree, trees.next())
+      codes.push_back(encode_levels(trees.get_levels()));
+    return !codes.empty();
+  }
+};
+
+void phase1_worker(const uint n, tree_source* source, shard_files* shards){
+  sequence_scratch scratch;
+  level_sequence level;
+  vector<uint64_t> codes;
+  vector<vector<shard_record> > buffer(shards->size());
+  while(source->get_chunk(codes))
+    for(const uint64_t code : codes){
+      decode_levels(code, n, level);
+      scratch.compute(level);
+      const shard_record r = { scratch.hash(), code };
+      vector<shard_record>& b(buffer[shards->shard_of(r.hash)]);
+      b.push_back(r);
+      if(b.size() >= shard_buffer_size){
+        shards->append(shards->shard_of(r.hash), b);
+        b.clear();
+      }
+    }
+  for(uint k = 0; k < buffer.size(); ++k) if(!buffer[k].empty()) shards->append(k, buffer[k]);
+}
+
+// find the groups of trees with equal sequences in shard k and write them into its group file
+void process_shard(const uint n, const string& dir, const uint k){
+  const string name(dir + "/shard." + to_string(k));
+  const string groups_name(dir + "/groups." + to_string(k));
+  struct stat st;
+  if(stat(groups_name.c_str(), &st) == 0) return; // done before an interruption
+
+  vector<shard_record> records;
+  FILE* f(fopen(name.c_str(), "rb"));
+  if(!f) FAIL("could not open "<<name);
+  if(stat(name.c_str(), &st)) FAIL("could not stat "<<name);
+  records.resize(st.st_size / sizeof(shard_record));
+  if(fread(records.data(), sizeof(shard_record), records.size(), f) != records.size()) FAIL("could not read "<<name);
+  fclose(f);
+  sort(records.begin(), records.end());
+
+  ostringstream out;
+  sequence_scratch scratch;
+  level_sequence level;
+  vector<pair<vector<uint>, uint64_t> > candidates;
+  for(size_t i = 0; i < records.size();){
+    size_t j = i + 1;
+    while((j < records.size()) && (records[j].hash == records[i].hash)) ++j;
+    if(j - i > 1){
+      // equal hashes, so the sequences are most probably equal, but we check
+      candidates.clear();
+      for(size_t r = i; r < j; ++r){
+        decode_levels(records[r].code, n, level);
+        scratch.compute(level);
+        candidates.push_back(make_pair(scratch.stati, records[r].code));
+      }
+      sort(candidates.begin(), candidates.end());
+      for(size_t a = 0; a < candidates.size();){
+        size_t b = a + 1;
+        while((b < candidates.size()) && (candidates[b].first == candidates[a].first)) ++b;
+        if(b - a > 1){
+          out << "sequence:";
+          for(const uint s : candidates[a].first) out << ' ' << s;
+          out << endl;
+          for(size_t c = a; c < b; ++c){
+            decode_levels(candidates[c].second, n, level);
+            out << "  levels:";
+            for(const uint l : level) out << ' ' << l;
+            out << endl;
+          }
+        }
+        a = b;
+      }
+    }
+    i = j;
+  }
+  {
+    ofstream g(groups_name + ".tmp");
+    g << out.str();
+    if(!g) FAIL("could not write "<<groups_name);
+  }
+  if(rename((groups_name + ".tmp").c_str(), groups_name.c_str())) FAIL("could not write "<<groups_name);
+}
+
+int main(int argc, char** argv){
+  parse_args(argc, argv);
+  const uint n(atoi(argv[1]));
+  if((n < 1) || (n > MAX_ENCODED_VERTICES)) FAIL("can only handle 1 to "<<MAX_ENCODED_VERTICES<<" vertices");
+  const uint num_threads(get_arg("threads", max(thread::hardware_concurrency(), 1U)));
+  const uint shard_bits(get_arg("shards", 8));
+  const size_t epoch_size((size_t)1 << get_arg("epoch", 22));
+  const string dir(get_string_arg("dir", "collisions." + to_string(n)));
+  const string out_name(get_string_arg("out", dir + "/groups"));
+  const string checkpoint_name(dir + "/checkpoint");
+
+  if(mkdir(dir.c_str(), 0755) && (errno != EEXIST)) FAIL("could not create "<<dir);
+  checkpoint cp;
+  if(cp.read(checkpoint_name)){
+    if((cp.n != n) || (cp.shard_bits != shard_bits)) FAIL(dir<<" belongs to a search with different parameters");
+    cout << "resuming after "<<cp.trees_done<<" trees"<<endl;
+  } else {
+    cp.n = n;
+    cp.shard_bits = shard_bits;
+    cp.trees_done = 0;
+    cp.shard_size.assign((size_t)1 << shard_bits, 0);
+    cp.write(checkpoint_name);
+  }
+
+  // phase 1: enumerate the trees epoch by epoch
+  {
+    shard_files shards(dir, shard_bits, cp.shard_size);
+    tree_source source(n, cp.trees_done);
+    while(source.valid()){
+      source.set_end(source.position() + epoch_size);
+      vector<std::thread> threads;
+      for(uint t = 0; t < num_threads; ++t) threads.push_back(std::thread(phase1_worker, n, &source, &shards));
+      for(std::thread& th : threads) th.join();
+      shards.sync(cp.shard_size);
+      cp.trees_done = source.position();
+      cp.write(checkpoint_name);
+      cerr << cp.trees_done << " trees done" << endl;
+    }
+  }
+
+  // phase 2: go through the shards in parallel, each thread takes the next shard when it's done with the last
+  size_t next_shard = 0;
+  std::mutex lock;
+  auto work = [&](){
+    while(true){
+      uint k;
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        if(next_shard == cp.shard_size.size()) return;
+        k = next_shard++;
+      }
+      process_shard(n, dir, k);
+    }
+  };
+  {
+    vector<std::thread> threads;
+    for(uint t = 1; t < num_threads; ++t) threads.push_back(std::thread(work));
+    work();
+    for(std::thread& th : threads) th.join();
+  }
+
+  // collect the groups of all shards
+  ofstream out(out_name);
+  size_t total_groups = 0;
+  for(size_t k = 0; k < cp.shard_size.size(); ++k){
+    ifstream g(dir + "/groups." + to_string(k));
+    string line;
+    while(getline(g, line)){
+      if(line.compare(0, 9, "sequence:") == 0) ++total_groups;
+      out << line << '\n';
+    }
+  }
+  if(!out) FAIL("could not write "<<out_name);
+  cout << cp.trees_done << " trees with "<< n << " vertices, " << total_groups << " groups with equal status sequences written to " << out_name << endl;
+  return 0;
+}
@@ -0,0 +1,301 @@
+#include "canon.hpp"
+#include <algorithm>
+
+namespace status {
+
+#define NO_VERTEX UINT_MAX
+
+  void parents_to_adjacency(const parent_array& parent, adjacency& adj){
+    const size_t n(parent.size());
+    adj.offset.assign(n + 1, 0);
+    for(size_t v = 0; v < n; ++v) if(parent[v] != NO_PARENT){
+      ++adj.offset[v + 1];
+      ++adj.offset[parent[v] + 1];
+    }
+    for(size_t v = 0; v < n; ++v) adj.offset[v + 1] += adj.offset[v];
+    adj.neighbor.resize(adj.offset[n]);
+    vector<uint> fill(adj.offset.begin(), adj.offset.end() - 1);
+    for(size_t v = 0; v < n; ++v) if(parent[v] != NO_PARENT){
+      adj.neighbor[fill[v]++] = parent[v];
+      adj.neighbor[fill[parent[v]]++] = v;
+    }
+  }
+
+  // compute the centroids from a BFS order and parents, using size as scratch
+  pair<uint, uint> find_centroids(const vector<uint>& order, const vector<uint>& up, vector<uint>& size){
+    const uint n(order.size());
+    pair<uint, uint> result(NO_VERTEX, NO_VERTEX);
+    size.assign(up.size(), 1);
+    // a vertex is a centroid iff neither its subtree nor any of its children's subtrees has more than n/2 vertices
+    vector<bool> heavy_child(up.size(), false);
+    for(uint i = n; i-- > 0;){
+      const uint v(order[i]);
+      if((2 * (n - size[v]) <= n) && !heavy_child[v]){
+        if(result.first == NO_VERTEX) result.first = v; else result.second = v;
+      }
+      if(up[v] != NO_VERTEX){
+        size[up[v]] += size[v];
+        if(2 * size[v] > n) heavy_child[up[v]] = true;
+      }
+    }
+    return result;
+  }
+
+  pair<uint, uint> compute_centroids(const adjacency& adj){
+    if(!adj.size()) return make_pair(NO_VERTEX, NO_VERTEX);
+    vector<uint> order(1, 0), up(adj.size()), size;
+    up[0] = NO_VERTEX;
+    for(size_t i = 0; i < order.size(); ++i){
+      const uint v(order[i]);
+      for(uint j = adj.offset[v]; j < adj.offset[v + 1]; ++j)
+        if(adj.neighbor[j] != up[v]){
+          up[adj.neighbor[j]] = v;
+          order.push_back(adj.neighbor[j]);
+        }
+    }
+    return find_centroids(order, up, size);
+  }
+
+  void canonizer::bfs(const adjacency& adj, const uint root){
+    const size_t n(adj.size());
+    order.clear();
+    order.reserve(n);
+    up.resize(n);
+    level_start.clear();
+    level_start.push_back(0);
+    order.push_back(root);
+    up[root] = NO_VERTEX;
+    size_t begin = 0;
+    while(begin < order.size()){
+      const size_t end(order.size());
+      for(size_t i = begin; i < end; ++i){
+        const uint v(order[i]);
+        for(uint j = adj.offset[v]; j < adj.offset[v + 1]; ++j)
+          if(adj.neighbor[j] != up[v]){
+            up[adj.neighbor[j]] = v;
+            order.push_back(adj.neighbor[j]);
+          }
+      }
+      level_start.push_back(end);
+      begin = end;
+    }
+  }
+
+  // sort the vertices order[begin...end-1] lexicographically by the ranks of their (sorted) children (AHU, Algorithm 3.2):
+  // 1. find out which symbols occur at each position of the lists by bucket-sorting all (position, symbol) pairs
+  // 2. go through the positions from the back, distributing the lists that are long enough into buckets by their symbol at
+  //    this position, and collecting the buckets of the occuring symbols in order;
+  //    lists of length l join the front of the queue before position l-1, so shorter lists end up before longer ones
+  // the time is linear in the number of vertices on this and the next level, as the alphabet is the ranks of the next level
+  void canonizer::sort_level(const uint begin, const uint end, const uint alphabet){
+    // 1. collect the (position, symbol) pairs and sort them by symbol and then stably by position
+    uint max_len = 0;
+    pairs.clear();
+    for(uint i = begin; i < end; ++i){
+      const uint v(order[i]);
+      const uint len(child_offset[v + 1] - child_offset[v]);
+      max_len = max(max_len, len);
+      for(uint j = 0; j < len; ++j) pairs.push_back(make_pair(j, rank[sorted_children[child_offset[v] + j]]));
+    }
+    pairs_tmp.resize(pairs.size());
+    // by symbol
+    bucket_head.assign(alphabet + 1, 0);
+    for(const pair<uint, uint>& p : pairs) ++bucket_head[p.second + 1];
+    for(uint a = 0; a < alphabet; ++a) bucket_head[a + 1] += bucket_head[a];
+    for(const pair<uint, uint>& p : pairs) pairs_tmp[bucket_head[p.second]++] = p;
+    // by position
+    position_start.assign(max_len + 2, 0);
+    for(const pair<uint, uint>& p : pairs_tmp) ++position_start[p.first + 2];
+    for(uint j = 0; j < max_len; ++j) position_start[j + 2] += position_start[j + 1];
+    for(const pair<uint, uint>& p : pairs_tmp) pairs[position_start[p.first + 1]++] = p;
+    // position_start[j] is now the start of the pairs of position j, remove the duplicate symbols to get nonempty
+    nonempty.clear();
+    for(uint j = 0; j < max_len; ++j){
+      const uint start(nonempty.size());
+      for(uint k = position_start[j]; k < position_start[j + 1]; ++k)
+        if((nonempty.size() == start) || (nonempty.back() != pairs[k].second)) nonempty.push_back(pairs[k].second);
+      position_start[j] = start;
+    }
+    position_start[max_len] = nonempty.size();
+
+    // 2. group the vertices by the length of their lists (counting sort), bucket_tail is the start of each length
+    bucket_tail.assign(max_len + 2, 0);
+    for(uint i = begin; i < end; ++i) ++bucket_tail[child_offset[order[i] + 1] - child_offset[order[i]] + 1];
+    for(uint l = 0; l <= max_len; ++l) bucket_tail[l + 1] += bucket_tail[l];
+    next_queue.resize(end - begin);
+    for(uint i = begin; i < end; ++i) next_queue[bucket_tail[child_offset[order[i] + 1] - child_offset[order[i]]]++] = order[i];
+    // now, the lists of length l are next_queue[bucket_tail[l-1]...bucket_tail[l]-1]
+    const vector<uint>& by_length(next_queue);
+    queue.clear();
+    bucket_head.assign(alphabet, NO_VERTEX);
+    symbol_tail.resize(alphabet);
+    by_rank.clear();
+    for(uint l = max_len; l > 0; --l){
+      // the lists of length l join the front of the queue (the buckets collect them before the others)
+      for(uint k = bucket_tail[l - 1]; k < bucket_tail[l]; ++k) by_rank.push_back(by_length[k]);
+      by_rank.insert(by_rank.end(), queue.begin(), queue.end());
+      // distribute into the buckets by symbol at position l-1 (stable)
+      for(const uint v : by_rank){
+        const uint symbol(rank[sorted_children[child_offset[v] + l - 1]]);
+        if(bucket_head[symbol] == NO_VERTEX) bucket_head[symbol] = v; else bucket_next[symbol_tail[symbol]] = v;
+        symbol_tail[symbol] = v;
+        bucket_next[v] = NO_VERTEX;
+      }
+      // collect the nonempty buckets in order
+      queue.clear();
+      for(uint k = position_start[l - 1]; k < position_start[l]; ++k){
+        const uint symbol(nonempty[k]);
+        for(uint v = bucket_head[symbol]; v != NO_VERTEX; v = bucket_next[v]) queue.push_back(v);
+        bucket_head[symbol] = NO_VERTEX;
+      }
+      by_rank.clear();
+    }
+    // finally, the empty lists (leaves) come first
+    for(uint k = 0; k < bucket_tail[0]; ++k) by_rank.push_back(by_length[k]);
+    by_rank.insert(by_rank.end(), queue.begin(), queue.end());
+  }
+
+  void canonizer::compute_ranks(const adjacency& adj){
+    const size_t n(adj.size());
+    const uint root(order[0]);
+    rank.resize(n);
+    bucket_next.resize(n);
+    // prepare the CSR for the sorted children
+    child_offset.resize(n + 1);
+    child_offset[0] = 0;
+    for(uint v = 0; v < n; ++v) child_offset[v + 1] = child_offset[v] + adj.degree(v) - (v == root ? 0 : 1);
+    sorted_children.resize(n ? n - 1 : 0);
+    fill.assign(child_offset.begin(), child_offset.end() - 1);
+
+    uint alphabet = 0;
+    for(uint d = level_start.size() - 1; d-- > 0;){
+      // the children (on level d+1) are in by_rank in increasing order of rank, so this sorts the children of each vertex
+      for(const uint w : by_rank) sorted_children[fill[up[w]]++] = w;
+      by_rank.clear();
+      if(d == level_start.size() - 2){
+        // the last level contains only leaves
+        for(uint i = level_start[d]; i < level_start[d + 1]; ++i) by_rank.push_back(order[i]);
+      } else sort_level(level_start[d], level_start[d + 1], alphabet);
+      // equal lists get equal ranks
+      alphabet = 0;
+      for(uint i = 0; i < by_rank.size(); ++i){
+        const uint v(by_rank[i]);
+        if(i){
+          const uint u(by_rank[i - 1]);
+          bool equal_lists(child_offset[u + 1] - child_offset[u] == child_offset[v + 1] - child_offset[v]);
+          for(uint j = 0; equal_lists && (j < child_offset[v + 1] - child_offset[v]); ++j)
+            equal_lists = (rank[sorted_children[child_offset[u] + j]] == rank[sorted_children[child_offset[v] + j]]);
+          if(!equal_lists) ++alphabet;
+        }
+        rank[v] = alphabet;
+      }
+      ++alphabet;
+    }
+  }
+
+  void canonizer::rooted_form(const adjacency& adj, const uint root, canonical_form& form){
+    form.clear();
+    if(!adj.size()) return;
+    by_rank.clear();
+    bfs(adj, root);
+    compute_ranks(adj);
+    // list the number of children in preorder, visiting the children by increasing rank
+    form.reserve(adj.size());
+    stack.assign(1, root);
+    while(!stack.empty()){
+      const uint v(stack.back());
+      stack.pop_back();
+      form.push_back(child_offset[v + 1] - child_offset[v]);
+      for(uint j = child_offset[v + 1]; j-- > child_offset[v];) stack.push_back(sorted_children[j]);
+    }
+  }
+
+  void canonizer::unrooted_form(const adjacency& adj, canonical_form& form){
+    form.clear();
+    if(!adj.size()) return;
+    bfs(adj, 0);
+    const pair<uint, uint> centroids(find_centroids(order, up, rank));
+    rooted_form(adj, centroids.first, form);
+    if(centroids.second != NO_VERTEX){
+      canonical_form other;
+      rooted_form(adj, centroids.second, other);
+      if(other < form) form.swap(other);
+    }
+  }
+
+  // ==================== pointer trees =========================
+
+  canonical_form rooted_canonical_form(const tree& t){
+    parent_array parent;
+    adjacency adj;
+    canonizer c;
+    canonical_form form;
+    tree_to_parents(t, parent);
+    parents_to_adjacency(parent, adj);
+    c.rooted_form(adj, 0, form);
+    return form;
+  }
+
+  canonical_form unrooted_canonical_form(const tree& t){
+    parent_array parent;
+    adjacency adj;
+    canonizer c;
+    canonical_form form;
+    tree_to_parents(t, parent);
+    parents_to_adjacency(parent, adj);
+    c.unrooted_form(adj, form);
+    return form;
+  }
+
+  bool isomorphic(const tree& t1, const tree& t2){
+    if(t1.get_size() != t2.get_size()) return false;
+    return unrooted_canonical_form(t1) == unrooted_canonical_form(t2);
+  }
+
+  bool rooted_isomorphic(const tree& t1, const tree& t2){
+    if(t1.get_size() != t2.get_size()) return false;
+    return rooted_canonical_form(t1) == rooted_canonical_form(t2);
+  }
+
+  // return whether the subtrees rooted at u and v are isomorph
+  bool subtrees_isomorph(const vertex* const u, const vertex* const v){
+    if(u->get_children().size() != v->get_children().size()) return false;
+    parent_array parent;
+    adjacency adj;
+    canonizer c;
+    canonical_form form_u, form_v;
+    subtree_to_parents(u, parent);
+    parents_to_adjacency(parent, adj);
+    c.rooted_form(adj, 0, form_u);
+    subtree_to_parents(v, parent);
+    if(parent.size() != form_u.size()) return false;
+    parents_to_adjacency(parent, adj);
+    c.rooted_form(adj, 0, form_v);
+    return form_u == form_v;
+  }
+
+  uint subtree_classes(const parent_array& parent, vector<uint>& cls){
+    const size_t n(parent.size());
+    cls.resize(n);
+    if(!n) return 0;
+    // the children in CSR
+    vector<uint> offset(n + 1, 0);
+    for(size_t v = 1; v < n; ++v) ++offset[parent[v] + 1];
+    for(size_t v = 0; v < n; ++v) offset[v + 1] += offset[v];
+    vector<uint> children(n - 1);
+    vector<uint> fill(offset.begin(), offset.begin() + n);
+    for(size_t v = 1; v < n; ++v) children[fill[parent[v]]++] = v;
+    // bottom-up, give each sorted list of children classes a number
+    unordered_map<canonical_form, uint, canonical_form_hasher> class_of;
+    canonical_form key;
+    for(size_t v = n; v-- > 0;){
+      key.clear();
+      for(uint j = offset[v]; j < offset[v + 1]; ++j) key.push_back(cls[children[j]]);
+      sort(key.begin(), key.end());
+      const auto it(class_of.insert(make_pair(key, (uint)class_of.size())).first);
+      cls[v] = it->second;
+    }
+    return class_of.size();
+  }
+
+};
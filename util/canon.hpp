@@ -0,0 +1,98 @@
+#ifndef CANON_HPP
+#define CANON_HPP
+
+#include "defs.hpp"
+#include "graphs.hpp"
+#include "flat.hpp"
+#include <vector>
+
+using namespace std;
+
+namespace status {
+
+  // an undirected tree in compressed sparse row format: the neighbors of v are neighbor[offset[v]...offset[v+1]-1]
+  struct adjacency {
+    vector<uint> offset;
+    vector<uint> neighbor;
+
+    inline size_t size() const { return offset.empty() ? 0 : offset.size() - 1; }
+    inline uint degree(const uint v) const { return offset[v + 1] - offset[v]; }
+  };
+
+  // build the adjacency of a flat tree (the parents need not be in topological order, the root has NO_PARENT)
+  void parents_to_adjacency(const parent_array& parent, adjacency& adj);
+
+  // the canonical form of a (rooted or unrooted) tree:
+  // the number of children of each vertex in preorder, where the children of each vertex are visited in canonical order;
+  // two trees are isomorphic if and only if their canonical forms are equal, so the forms can be hashed for deduplication
+  typedef vector<uint> canonical_form;
+
+  class canonical_form_hasher{
+  public:
+    size_t operator()(const canonical_form& f) const{
+      size_t result = f.size();
+      for(uint x : f) result = rol(result, 7) ^ (x * 0x9e3779b97f4a7c15ULL);
+      return result;
+    }
+  };
+
+  // compute canonical labels and forms of trees with the Aho-Hopcroft-Ullman scheme, going up level by level and
+  // replacing the sorted list of labels of the children of each vertex by its rank among all lists of this level;
+  // the lists are sorted lexicographically by AHU's bucket sort, so the whole thing runs in linear time
+  // all scratch space is kept between calls, so canonizing many trees does not allocate after a while
+  class canonizer {
+    // the tree rooted at the chosen root: vertices in BFS order, the first vertex of each level and the parents
+    vector<uint> order;
+    vector<uint> level_start;
+    vector<uint> up;
+    // rank of each vertex' subtree among the subtrees of its level
+    vector<uint> rank;
+    // the children of each vertex sorted by rank (CSR, indexed by vertex)
+    vector<uint> child_offset;
+    vector<uint> sorted_children;
+    vector<uint> fill;
+    // scratch for the lexicographic sort
+    vector<uint> by_rank;
+    vector<uint> bucket_head, bucket_next, bucket_tail, symbol_tail;
+    vector<uint> queue, next_queue;
+    vector<uint> position_start, nonempty;
+    vector<pair<uint, uint> > pairs, pairs_tmp;
+    // scratch for the preorder
+    vector<uint> stack;
+
+    // build order, level_start and up for the given root
+    void bfs(const adjacency& adj, const uint root);
+    // compute rank, child_offset and sorted_children level by level from the bottom
+    void compute_ranks(const adjacency& adj);
+    // lexicographically sort the vertices in [begin, end) of the BFS order by their lists of children ranks
+    void sort_level(const uint begin, const uint end, const uint alphabet);
+  public:
+    // compute the canonical form of the tree rooted at root
+    void rooted_form(const adjacency& adj, const uint root, canonical_form& form);
+    // compute the canonical form of the unrooted tree (rooted at its centroid, taking the smaller form if there are two)
+    void unrooted_form(const adjacency& adj, canonical_form& form);
+
+    // return the rank of the subtree of v (a vertex of adj) after the last rooted_form: vertices on the same level
+    // have equal ranks iff their subtrees are isomorphic
+    inline uint get_rank(const uint v) const { return rank[v]; }
+  };
+
+  // find the (at most two) centroids of an unrooted tree, that is, the vertices of minimum status
+  pair<uint, uint> compute_centroids(const adjacency& adj);
+
+  // convenience functions for pointer trees
+  canonical_form rooted_canonical_form(const tree& t);
+  canonical_form unrooted_canonical_form(const tree& t);
+  // test if two trees are isomorphic (as unrooted or rooted trees)
+  bool isomorphic(const tree& t1, const tree& t2);
+  bool rooted_isomorphic(const tree& t1, const tree& t2);
+  // return whether the subtrees rooted at u and v are isomorph
+  bool subtrees_isomorph(const vertex* const u, const vertex* const v);
+
+  // compute subtree isomorphism classes of a flat tree: cls[u] == cls[v] iff the subtrees of u and v are isomorphic
+  // (on any level; the classes are numbered from 0 and the number of classes is returned)
+  uint subtree_classes(const parent_array& parent, vector<uint>& cls);
+
+};
+
+#endif
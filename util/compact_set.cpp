@@ -1,12 +1,175 @@
 #include "compact_set.hpp"
+#include "random.hpp"
+#include <algorithm>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 namespace status {
 
+#ifdef __AVX2__
+  inline __m256i load_counters(const uint32_t* const p){ return _mm256_loadu_si256((const __m256i*)p); }
+  inline void store_counters(uint32_t* const p, const __m256i x){ _mm256_storeu_si256((__m256i*)p, x); }
+  // all bits set in the lanes that are 0
+  inline __m256i zero_lanes(const __m256i x){ return _mm256_cmpeq_epi32(x, _mm256_setzero_si256()); }
+#endif
+
+  void dense_multiset::clear(){
+    fill(count.begin(), count.end(), 0);
+  }
+
+  bool dense_multiset::empty() const{
+#ifdef __AVX2__
+    for(size_t i = 0; i < count.size(); i += COUNTERS_PER_VECTOR){
+      const __m256i a(load_counters(count.data() + i));
+      if(!_mm256_testz_si256(a, a)) return false;
+    }
+#else
+    for(const uint32_t c : count) if(c) return false;
+#endif
+    return true;
+  }
+
+  uint dense_multiset::distinct() const{
+    uint result = 0;
+#ifdef __AVX2__
+    for(size_t i = 0; i < count.size(); i += COUNTERS_PER_VECTOR)
+      result += COUNTERS_PER_VECTOR - __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(zero_lanes(load_counters(count.data() + i)))));
+#else
+    for(const uint32_t c : count) if(c) ++result;
+#endif
+    return result;
+  }
+
+  size_t dense_multiset::hash() const{
+    // each ID gets its own odd factor; the compiler vectorizes this on its own
+    uint32_t result = universe;
+    for(uint32_t i = 0; i < count.size(); ++i) result += count[i] * ((i * 0x9e3779b9U) | 1);
+    return mix64(result);
+  }
+
+  void dense_multiset::add(const dense_multiset& X){
+    assert(X.universe == universe);
+#ifdef __AVX2__
+    for(size_t i = 0; i < count.size(); i += COUNTERS_PER_VECTOR)
+      store_counters(count.data() + i, _mm256_add_epi32(load_counters(count.data() + i), load_counters(X.count.data() + i)));
+#else
+    for(size_t i = 0; i < count.size(); ++i) count[i] += X.count[i];
+#endif
+  }
+
+  void dense_multiset::remove_all(const dense_multiset& X){
+    assert(X.universe == universe);
+#ifdef __AVX2__
+    for(size_t i = 0; i < count.size(); i += COUNTERS_PER_VECTOR)
+      store_counters(count.data() + i, _mm256_and_si256(load_counters(count.data() + i), zero_lanes(load_counters(X.count.data() + i))));
+#else
+    for(size_t i = 0; i < count.size(); ++i) if(X.count[i]) count[i] = 0;
+#endif
+  }
+
+  bool dense_multiset::contains(const dense_multiset& X) const{
+    assert(X.universe == universe);
+#ifdef __AVX2__
+    // we contain x iff max(us, x) = us in each lane
+    for(size_t i = 0; i < count.size(); i += COUNTERS_PER_VECTOR){
+      const __m256i a(load_counters(count.data() + i));
+      const __m256i diff(_mm256_xor_si256(a, _mm256_max_epu32(a, load_counters(X.count.data() + i))));
+      if(!_mm256_testz_si256(diff, diff)) return false;
+    }
+#else
+    for(size_t i = 0; i < count.size(); ++i) if(count[i] < X.count[i]) return false;
+#endif
+    return true;
+  }
+
+  bool dense_multiset::meets(const dense_multiset& X) const{
+    assert(X.universe == universe);
+#ifdef __AVX2__
+    for(size_t i = 0; i < count.size(); i += COUNTERS_PER_VECTOR){
+      const __m256i both(_mm256_min_epu32(load_counters(count.data() + i), load_counters(X.count.data() + i)));
+      if(!_mm256_testz_si256(both, both)) return true;
+    }
+#else
+    for(size_t i = 0; i < count.size(); ++i) if(count[i] && X.count[i]) return true;
+#endif
+    return false;
+  }
+
+  bool dense_multiset::operator==(const dense_multiset& X) const{
+    if(X.universe != universe) return false;
+#ifdef __AVX2__
+    for(size_t i = 0; i < count.size(); i += COUNTERS_PER_VECTOR){
+      const __m256i diff(_mm256_xor_si256(load_counters(count.data() + i), load_counters(X.count.data() + i)));
+      if(!_mm256_testz_si256(diff, diff)) return false;
+    }
+    return true;
+#else
+    return count == X.count;
+#endif
+  }
+
+  bool compact_multiset::some_sets_contain_all_of(const dense_multiset& X) const{
+    assert(X.universe == fix.universe);
+#ifdef __AVX2__
+    for(size_t i = 0; i < fix.count.size(); i += COUNTERS_PER_VECTOR){
+      const __m256i both(_mm256_add_epi32(load_counters(fix.count.data() + i), load_counters(variable.count.data() + i)));
+      const __m256i diff(_mm256_xor_si256(both, _mm256_max_epu32(both, load_counters(X.count.data() + i))));
+      if(!_mm256_testz_si256(diff, diff)) return false;
+    }
+#else
+    for(size_t i = 0; i < fix.count.size(); ++i) if(fix.count[i] + variable.count[i] < X.count[i]) return false;
+#endif
+    return true;
+  }
+
+  void compact_multiset::remove_sets_not_containing_all_of(const dense_multiset& X){
+    assert(X.universe == fix.universe);
+    // if some item of X is in no set, no set remains; otherwise, the items of X that are only optional become mandatory
+#ifdef __AVX2__
+    for(size_t i = 0; i < fix.count.size(); i += COUNTERS_PER_VECTOR){
+      const __m256i absent(_mm256_or_si256(load_counters(fix.count.data() + i), load_counters(variable.count.data() + i)));
+      if(!_mm256_testc_si256(zero_lanes(load_counters(X.count.data() + i)), zero_lanes(absent))){
+        clear();
+        return;
+      }
+    }
+    const __m256i one(_mm256_set1_epi32(1));
+    for(size_t i = 0; i < fix.count.size(); i += COUNTERS_PER_VECTOR){
+      const __m256i f(load_counters(fix.count.data() + i));
+      // the lanes with an item of X that is not fix
+      const __m256i optional(_mm256_andnot_si256(zero_lanes(load_counters(X.count.data() + i)), zero_lanes(f)));
+      store_counters(fix.count.data() + i, _mm256_blendv_epi8(f, one, optional));
+      store_counters(variable.count.data() + i, _mm256_andnot_si256(optional, load_counters(variable.count.data() + i)));
+    }
+#else
+    for(size_t i = 0; i < fix.count.size(); ++i)
+      if(X.count[i] && !fix.count[i] && !variable.count[i]){
+        clear();
+        return;
+      }
+    for(size_t i = 0; i < fix.count.size(); ++i)
+      if(X.count[i] && !fix.count[i]){
+        fix.count[i] = 1;
+        variable.count[i] = 0;
+      }
+#endif
+  }
 
 }
 
+ostream& operator<<(ostream& os, const status::dense_multiset& s){
+  os << '(';
+  bool any(false);
+  for(uint x = 0; x < s.get_universe(); ++x)
+    if(s[x]){
+      os << s[x] << 'x' << x << ' ';
+      any = true;
+    }
+  return os << (any ? "\b)" : ")");
+}
+
 ostream& operator<<(ostream& os, const status::compact_multiset& s){
   // the set is somewhat well described by the fix set times the powerset of variable
   return os << s.fix << "xP" << s.variable;
 }
-
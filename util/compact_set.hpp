@@ -2,45 +2,91 @@
 #define COMPACT_SETS_HPP
 
 #include "defs.hpp"
-#include <unordered_set>
+#include <stdint.h>
+#include <vector>
 #include <list>
 
 
 using namespace std;
 
-namespace status { class compact_multiset; }
+namespace status { class dense_multiset; class compact_multiset; }
 
+ostream& operator<<(ostream& os, const status::dense_multiset& s);
 ostream& operator<<(ostream& os, const status::compact_multiset& s);
 
 namespace status{
 
+  // the number of counters that an AVX2 register holds
+#define COUNTERS_PER_VECTOR 8
+
+  // a multiset of dense IDs 0...universe-1 as array of multiplicities; the array is padded with zeros to whole vectors,
+  // so the operations on whole multisets (of the same universe) go through 8 counters per instruction with AVX2
+  // (the scalar loops are used if the compiler does not target AVX2)
+  class dense_multiset {
+    vector<uint32_t> count;
+    uint universe;
+  public:
+    dense_multiset(const uint _universe = 0):
+      count((_universe + COUNTERS_PER_VECTOR - 1) & ~(COUNTERS_PER_VECTOR - 1), 0), universe(_universe) {}
+
+    inline uint get_universe() const { return universe; }
+    inline uint32_t operator[](const uint x) const { return count[x]; }
+
+    // add or remove an item
+    inline void add(const uint x, const uint32_t times = 1) { count[x] += times; }
+    inline void remove_once(const uint x) { if(count[x]) --count[x]; }
+    inline void remove_all(const uint x) { count[x] = 0; }
+    inline void set(const uint x, const uint32_t times) { count[x] = times; }
+
+    // remove all items
+    void clear();
+    // return whether there is no item
+    bool empty() const;
+    // the number of different items
+    uint distinct() const;
+    // a hash of the multiplicities
+    size_t hash() const;
+
+    // add all items of X
+    void add(const dense_multiset& X);
+    // remove all occurances of each item of X
+    void remove_all(const dense_multiset& X);
+    // return whether each item occurs at least as often as in X
+    bool contains(const dense_multiset& X) const;
+    // return whether some item of X occurs
+    bool meets(const dense_multiset& X) const;
+    bool operator==(const dense_multiset& X) const;
+    inline bool operator!=(const dense_multiset& X) const { return !(*this == X); }
+
+    friend class compact_multiset;
+  };
 
   // a compact description of a list of sets in two parts:
   // 1. a set "fix"
   // 2. a set "variable"
   // the list then contains exactly the sets obtained by combining "fix" with each subset of "variable"
+  // the sets are multisets of the dense IDs 0...universe-1 (see dense_multiset), and so are the arguments of the
+  // operations on many items at once
   class compact_multiset{
-    unordered_multiset<uint> fix;
-    unordered_multiset<uint> variable;
+    dense_multiset fix;
+    dense_multiset variable;
   public:
-    compact_multiset(const list<uint>& _fix, const list<uint>& _variable){
-      multiply_with_set(_fix);
-      multiply_with_subsets(_variable);
-    }
+    compact_multiset(const dense_multiset& _fix, const dense_multiset& _variable):
+      fix(_fix), variable(_variable) {}
     // constructor
-    compact_multiset():fix(), variable() {};
+    compact_multiset(const uint universe = 0):fix(universe), variable(universe) {};
     // clear
     inline void clear(){
       fix.clear();
       variable.clear();
     }
     // multiply all sets in the list with one set X (add this set to all sets in the list)
-    inline void multiply_with_set(const list<uint>& X){
-      for(uint x: X) fix.insert(x);
+    inline void multiply_with_set(const dense_multiset& X){
+      fix.add(X);
     }
     // multiply all sets in the list with all subsets of X (add all subsets to all sets in the list)
-    inline void multiply_with_subsets(const list<uint>& X){
-      for(uint x: X) variable.insert(x);
+    inline void multiply_with_subsets(const dense_multiset& X){
+      variable.add(X);
     }
     // return whether there are some elements that are fix
     inline bool has_no_fixed_elements() const {
@@ -49,61 +95,56 @@ namespace status{
 
     // add or remove a (list of) items from all sets
     inline void add_to_all(const uint x){
-      fix.insert(x);
+      fix.add(x);
     }
     inline void remove_all_from_all(const uint x){
-      fix.erase(x);
-      variable.erase(x);
+      fix.remove_all(x);
+      variable.remove_all(x);
     }
     inline void remove_once_from_all(const uint x){
-      erase_once(fix, x);
-      erase_once(variable, x);
+      fix.remove_once(x);
+      variable.remove_once(x);
     }
-    inline void add_to_all(const list<uint>& X){
-      for(auto x: X) add_to_all(x);
+    inline void add_to_all(const dense_multiset& X){
+      fix.add(X);
     }
-    inline void remove_all_from_all(const list<uint>& X){
-      for(auto x: X) remove_all_from_all(x);
+    inline void remove_all_from_all(const dense_multiset& X){
+      fix.remove_all(X);
+      variable.remove_all(X);
     }
 
-    // check containment of (lists of) items in all/some of the sets
+    // check containment of (multisets of) items in all/some of the sets
     bool all_sets_contain(const uint x) const{
-      return fix.find(x) != fix.end();
+      return fix[x] != 0;
     }
     bool some_sets_contain(const uint x) const{
-      return (fix.find(x) != fix.end()) || (variable.find(x) != variable.end());
-    }
-    bool all_sets_contain_all_of(const list<uint>& X) const{
-      for(auto x: X) if(!(all_sets_contain(x))) return false;
-      return true;
+      return (fix[x] != 0) || (variable[x] != 0);
     }
-    bool some_sets_contain_all_of(const list<uint>& X) const{
-      // due to the nature of this list of sets, this is equal to: for each x in X, there is some set containing x
-      for(auto x: X) if(!(some_sets_contain(x))) return false;
-      return true;
+    bool all_sets_contain_all_of(const dense_multiset& X) const{
+      return fix.contains(X);
     }
+    // due to the nature of this list of sets, this is equal to: fix and variable together contain X
+    bool some_sets_contain_all_of(const dense_multiset& X) const;
 
     // remove all sets that (do not) contain an item
     void remove_sets_containing(const uint x){
-      if(fix.find(x) == fix.end()) // if x not in fix, then just remove all occurances of it from variable
-        variable.erase(x);
+      if(!fix[x]) // if x not in fix, then just remove all occurances of it from variable
+        variable.remove_all(x);
       else clear(); // if x in fix, then all sets contain x, so clear the compact_set
     }
     void remove_sets_not_containing(const uint x){
-      if(fix.find(x) == fix.end()){ // if x in fix, then x is already in all sets
-        if(variable.find(x) != variable.end()){ // if x is optional, then make it madatory
-          fix.insert(x);
-          variable.erase(x);
+      if(!fix[x]){ // if x in fix, then x is already in all sets
+        if(variable[x]){ // if x is optional, then make it madatory
+          fix.set(x, 1);
+          variable.remove_all(x);
         } else clear(); // if x is not in any set, then remove all sets
       }
     }
     // remove all sets that (do not) contain an item
-    void remove_sets_containing_any_of(const list<uint>& X){
-      for(auto x: X) remove_sets_containing(x);
-    }
-    void remove_sets_not_containing_all_of(const list<uint>& X){
-      for(auto x: X) remove_sets_not_containing(x);
+    void remove_sets_containing_any_of(const dense_multiset& X){
+      if(fix.meets(X)) clear(); else variable.remove_all(X);
     }
+    void remove_sets_not_containing_all_of(const dense_multiset& X);
 
     // return whether the list contains no element
     bool empty() const{
@@ -0,0 +1,168 @@
+#include "dynamic.hpp"
+
+namespace status {
+
+  // ==================== link-cut forest =========================
+
+  uint link_cut_forest::add_node(const int64_t value){
+    const node x = { { NO_NODE, NO_NODE }, NO_NODE, value, value, 1, 0 };
+    if(!free_nodes.empty()){
+      const uint result(free_nodes.back());
+      free_nodes.pop_back();
+      nodes[result] = x;
+      return result;
+    }
+    nodes.push_back(x);
+    return nodes.size() - 1;
+  }
+
+  void link_cut_forest::remove_node(const uint x){
+    access(x);
+    assert(nodes[x].child[0] == NO_NODE);
+    free_nodes.push_back(x);
+  }
+
+  void link_cut_forest::rotate(const uint x){
+    const uint p(nodes[x].parent);
+    const uint g(nodes[p].parent);
+    const uint side(nodes[p].child[1] == x ? 1 : 0);
+    const uint moved(nodes[x].child[1 - side]);
+    // x takes the place of p below g (if p is the root of its splay tree, x inherits its path-parent)
+    if(!is_splay_root(p)) nodes[g].child[nodes[g].child[1] == p ? 1 : 0] = x;
+    nodes[x].parent = g;
+    nodes[x].child[1 - side] = p;
+    nodes[p].parent = x;
+    nodes[p].child[side] = moved;
+    if(moved != NO_NODE) nodes[moved].parent = p;
+    pull(p);
+    pull(x);
+  }
+
+  void link_cut_forest::splay(const uint x){
+    // push the pending additions down the splay path, top to bottom
+    stack.clear();
+    stack.push_back(x);
+    for(uint y = x; !is_splay_root(y); y = nodes[y].parent) stack.push_back(nodes[y].parent);
+    while(!stack.empty()){
+      push(stack.back());
+      stack.pop_back();
+    }
+    while(!is_splay_root(x)){
+      const uint p(nodes[x].parent);
+      if(!is_splay_root(p)){
+        const uint g(nodes[p].parent);
+        // zig-zig rotates the parent first, zig-zag rotates x twice
+        if((nodes[g].child[0] == p) == (nodes[p].child[0] == x)) rotate(p); else rotate(x);
+      }
+      rotate(x);
+    }
+  }
+
+  uint link_cut_forest::access(const uint x){
+    uint last = NO_NODE;
+    for(uint y = x; y != NO_NODE; y = nodes[y].parent){
+      splay(y);
+      nodes[y].child[1] = last;
+      pull(y);
+      last = y;
+    }
+    splay(x);
+    return last;
+  }
+
+  void link_cut_forest::link(const uint x, const uint y){
+    access(x);
+    assert(nodes[x].child[0] == NO_NODE);
+    nodes[x].parent = y;
+  }
+
+  void link_cut_forest::cut(const uint x){
+    access(x);
+    const uint above(nodes[x].child[0]);
+    assert(above != NO_NODE);
+    nodes[above].parent = NO_NODE;
+    nodes[x].child[0] = NO_NODE;
+    pull(x);
+  }
+
+  // ==================== dynamic stati =========================
+
+  dynamic_stati::dynamic_stati(tree& _t): t(_t), depth_sum(0) {
+    if(t.empty()) return;
+    // BFS, computing the subtree sizes bottom-up afterwards
+    vector<const vertex*> order(1, t.get_root());
+    vector<uint> depth(1, 0);
+    for(size_t i = 0; i < order.size(); ++i)
+      for(const vertex* c : order[i]->get_children()){
+        order.push_back(c);
+        depth.push_back(depth[i] + 1);
+        depth_sum += depth[i] + 1;
+      }
+    unordered_map<const vertex*, uint> subtree_size;
+    for(size_t i = order.size(); i-- > 0;){
+      uint s = 1;
+      for(const vertex* c : order[i]->get_children()) s += subtree_size[c];
+      subtree_size[order[i]] = s;
+    }
+    // at first, all edges are path-parent pointers
+    for(const vertex* v : order){
+      const uint x(sizes.add_node(subtree_size[v]));
+      id[v] = x;
+      if(!v->is_root()) sizes.link(x, get_id(v->get_parent()));
+    }
+  }
+
+  vertex* dynamic_stati::add_leaf(vertex* const parent){
+    const uint p(get_id(parent));
+    vertex* const leaf(t.add_vertex(parent));
+    const uint x(sizes.add_node(1));
+    id[leaf] = x;
+    sizes.path_add(p, 1);
+    depth_sum += sizes.depth(p) + 1;
+    sizes.link(x, p);
+    return leaf;
+  }
+
+  void dynamic_stati::remove_leaf(vertex* const leaf){
+    assert(leaf->is_leaf() && !leaf->is_root());
+    const uint x(get_id(leaf));
+    depth_sum -= sizes.depth(x);
+    sizes.cut(x);
+    sizes.path_add(get_id(leaf->get_parent()), -1);
+    sizes.remove_node(x);
+    id.erase(leaf);
+    t.remove_leaf(leaf);
+  }
+
+  void dynamic_stati::move_subtree(vertex* const v, vertex* const new_parent){
+    assert(!v->is_root());
+    assert(!is_ancestor(v, new_parent));
+    const uint x(get_id(v));
+    const uint p(get_id(new_parent));
+    const int64_t s(sizes.get_value(x));
+    // all vertices in the subtree of v change their depth by the same amount
+    const int64_t old_depth(sizes.depth(x));
+    const int64_t new_depth(sizes.depth(p) + 1);
+    depth_sum += s * (new_depth - old_depth);
+    sizes.cut(x);
+    sizes.path_add(get_id(v->get_parent()), -s);
+    sizes.path_add(p, s);
+    sizes.link(x, p);
+    t.move_subtree(v, new_parent);
+  }
+
+  uint dynamic_stati::get_status(const vertex* const v){
+    const uint x(get_id(v));
+    const int64_t n(t.get_size());
+    // the path sum includes the root, whose subtree has all n vertices
+    const int64_t path(sizes.path_sum(x) - n);
+    return depth_sum + n * sizes.depth(x) - 2 * path;
+  }
+
+  sequence_t dynamic_stati::get_sequence(){
+    sequence_t result;
+    for(const auto& v : id) result[get_status(v.first)]++;
+    return result;
+  }
+
+};
@@ -0,0 +1,127 @@
+#ifndef DYNAMIC_HPP
+#define DYNAMIC_HPP
+
+#include "defs.hpp"
+#include "graphs.hpp"
+#include "seq.hpp"
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+namespace status {
+
+#define NO_NODE UINT_MAX
+
+  // a link-cut forest of rooted trees (Sleator & Tarjan) whose nodes carry numbers; in amortized O(log n), it can
+  // add to all numbers on the path from a node to its root, sum them up and count the nodes on such paths
+  // nothing is recursive, so the depth of the trees does not matter
+  class link_cut_forest {
+    struct node {
+      uint child[2];
+      // parent in the splay tree or, for the root of a splay tree, the path-parent
+      uint parent;
+      int64_t value;
+      // sum of values and number of nodes in the splay subtree, and the amount yet to be added to the splay subtree
+      int64_t sum;
+      uint count;
+      int64_t pending;
+    };
+    vector<node> nodes;
+    vector<uint> free_nodes;
+    vector<uint> stack;
+
+    inline bool is_splay_root(const uint x) const {
+      const uint p(nodes[x].parent);
+      return (p == NO_NODE) || ((nodes[p].child[0] != x) && (nodes[p].child[1] != x));
+    }
+    inline void apply(const uint x, const int64_t amount){
+      if(x == NO_NODE) return;
+      nodes[x].value += amount;
+      nodes[x].sum += amount * nodes[x].count;
+      nodes[x].pending += amount;
+    }
+    inline void push(const uint x){
+      if(nodes[x].pending){
+        apply(nodes[x].child[0], nodes[x].pending);
+        apply(nodes[x].child[1], nodes[x].pending);
+        nodes[x].pending = 0;
+      }
+    }
+    inline void pull(const uint x){
+      node& nx(nodes[x]);
+      nx.sum = nx.value;
+      nx.count = 1;
+      for(const uint c : nx.child) if(c != NO_NODE){
+        nx.sum += nodes[c].sum;
+        nx.count += nodes[c].count;
+      }
+    }
+    void rotate(const uint x);
+    void splay(const uint x);
+    // make the path from the root to x preferred and x the root of its splay tree, return the last node where we
+    // changed to another preferred path (this is the lowest common ancestor of x and the last accessed node)
+    uint access(const uint x);
+  public:
+    // add a new node that is the root of its own tree
+    uint add_node(const int64_t value);
+    // remove a node that has neither parent nor children, its number may be given to a new node later
+    void remove_node(const uint x);
+
+    // make the root x a child of y
+    void link(const uint x, const uint y);
+    // remove the edge from x to its parent
+    void cut(const uint x);
+
+    // add amount to all numbers on the path from x to its root
+    inline void path_add(const uint x, const int64_t amount) { access(x); apply(x, amount); }
+    // return the sum of the numbers on the path from x to its root
+    inline int64_t path_sum(const uint x) { access(x); return nodes[x].sum; }
+    // return the depth of x (the root has depth 0)
+    inline uint depth(const uint x) { access(x); return nodes[x].count - 1; }
+    // return the number of x
+    inline int64_t get_value(const uint x) { access(x); return nodes[x].value; }
+    // return the lowest common ancestor of x and y (which must be in the same tree)
+    inline uint lca(const uint x, const uint y) { access(x); return access(y); }
+  };
+
+  // the stati of a tree under modifications: if the root is r and D is the sum of the depths, then
+  //    status(v) = D + n * depth(v) - 2 * (sum of the subtree sizes of the vertices on the path from r to v, except r),
+  // since each vertex u contributes depth(u) + depth(v) - 2 * depth(lca(u,v)) and the last part is the number of
+  // non-root vertices on the path to v whose subtree contains u
+  // so we keep the subtree sizes in a link-cut forest: adding or removing a leaf or re-hanging a subtree adds to the sizes
+  // on one or two paths to the root and changes D by a product, so each update and each status query takes
+  // amortized O(log n)
+  // note that a single update changes the stati of all vertices, so the sequence cannot be kept explicitly within
+  // this time; it is computed from the stati on request in O(n log n)
+  class dynamic_stati {
+    tree& t;
+    link_cut_forest sizes;
+    unordered_map<const vertex*, uint> id;
+    uint64_t depth_sum;
+
+    inline uint get_id(const vertex* const v) const { return id.at(v); }
+  public:
+    // start keeping the stati of t; from now on, t should only be modified through this
+    dynamic_stati(tree& _t);
+
+    // add a new leaf below parent and return it
+    vertex* add_leaf(vertex* const parent);
+    // remove a leaf that is not the root
+    void remove_leaf(vertex* const leaf);
+    // hang the subtree of v below new_parent (new_parent must not be in the subtree of v)
+    void move_subtree(vertex* const v, vertex* const new_parent);
+
+    // return the status of v
+    uint get_status(const vertex* const v);
+    // return the number of vertices in the subtree of v
+    inline uint get_subtree_size(const vertex* const v) { return sizes.get_value(get_id(v)); }
+    // return true iff u is an ancestor of v (or u == v)
+    inline bool is_ancestor(const vertex* const u, const vertex* const v) { return sizes.lca(get_id(u), get_id(v)) == get_id(u); }
+    // compute the status sequence
+    sequence_t get_sequence();
+  };
+
+};
+
+#endif
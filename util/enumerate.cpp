@@ -0,0 +1,109 @@
+#include "enumerate.hpp"
+
+namespace status {
+
+  free_tree_enumerator::free_tree_enumerator(const uint num_vertices):
+    n(num_vertices), level(num_vertices), done(num_vertices == 0)
+  {
+    // start with the path rooted at its center
+    for(uint i = 0; i <= n / 2; ++i) level[i] = i;
+    for(uint i = n / 2 + 1; i < n; ++i) level[i] = i - n / 2;
+    if(n > 2) make_canonical();
+  }
+
+  bool free_tree_enumerator::next_rooted(uint p){
+    if(p == 0) return false;
+    uint q = p - 1;
+    while(level[q] != level[p] - 1) --q;
+    // repeat the subtree sequence starting at q until the end
+    for(uint i = p; i < n; ++i) level[i] = level[i - p + q];
+    return true;
+  }
+
+  bool free_tree_enumerator::make_canonical(){
+    // split the tree into the first subtree of the root (left) and the rest (the root with all other subtrees)
+    uint m = 2;
+    while((m < n) && (level[m] != 1)) ++m;
+    uint left_height = 0, rest_height = 0;
+    for(uint i = 1; i < m; ++i) left_height = max(left_height, level[i] - 1);
+    for(uint i = m; i < n; ++i) rest_height = max(rest_height, level[i]);
+    const uint left_size(m - 1), rest_size(n - m + 1);
+
+    // the rooting is canonical iff the left subtree is not higher than the rest and, if they have the same height,
+    // it is not larger than the rest and, if they have the same size, its level sequence is not larger than the rest's
+    bool canonical(rest_height >= left_height);
+    if(canonical && (rest_height == left_height)){
+      if(left_size > rest_size) canonical = false;
+      else if(left_size == rest_size){
+        // rest is 0 followed by level[m...n-1]
+        for(uint i = 0; i < left_size; ++i){
+          const uint l(level[1 + i] - 1);
+          const uint r(i ? level[m + i - 1] : 0);
+          if(l != r){
+            canonical = (l < r);
+            break;
+          }
+        }
+      }
+    }
+    if(canonical) return true;
+
+    // jump to the next canonical tree by advancing the left subtree and, if needed, making the rest a path of the right height
+    const uint p(left_size);
+    const uint old_level(level[p]);
+    if(!next_rooted(p)) return false;
+    if(old_level > 2){
+      m = 2;
+      while((m < n) && (level[m] != 1)) ++m;
+      uint new_height = 0;
+      for(uint i = 1; i < m; ++i) new_height = max(new_height, level[i] - 1);
+      for(uint j = 0; j <= new_height; ++j) level[n - new_height - 1 + j] = j + 1;
+    }
+    return true;
+  }
+
+  bool free_tree_enumerator::next(){
+    if(done) return false;
+    if(n <= 2) return !(done = true);
+    // the last vertex that is not a child of the root is the one that changes in the rooted successor
+    uint p = n - 1;
+    while(level[p] == 1) --p;
+    if(!next_rooted(p) || !make_canonical()) return !(done = true);
+    return true;
+  }
+
+  void levels_to_parents(const level_sequence& level, parent_array& parent){
+    parent.resize(level.size());
+    if(level.empty()) return;
+    // parent[i] is the last vertex before i that is one level higher, that is, the last vertex we saw on that level
+    vector<uint> last(level.size());
+    parent[0] = NO_PARENT;
+    last[0] = 0;
+    for(uint i = 1; i < level.size(); ++i){
+      parent[i] = last[level[i] - 1];
+      last[level[i]] = i;
+    }
+  }
+
+  uint64_t encode_levels(const level_sequence& level){
+    assert(level.size() <= MAX_ENCODED_VERTICES);
+    uint64_t code = 0;
+    uint bit = 0;
+    for(uint i = 1; i < level.size(); ++i){
+      // go up from level[i-1] to the parent of i, then down to i
+      bit += level[i - 1] + 1 - level[i];
+      code |= (uint64_t)1 << bit++;
+    }
+    return code;
+  }
+
+  void decode_levels(uint64_t code, const uint num_vertices, level_sequence& level){
+    level.resize(num_vertices);
+    if(!num_vertices) return;
+    level[0] = 0;
+    uint depth = 0;
+    for(uint i = 1; i < num_vertices; code >>= 1)
+      if(code & 1) depth = level[i++] = depth + 1; else --depth;
+  }
+
+};
@@ -0,0 +1,52 @@
+#ifndef ENUMERATE_HPP
+#define ENUMERATE_HPP
+
+#include "defs.hpp"
+#include "flat.hpp"
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+namespace status {
+
+  // a rooted tree as level sequence: the depth of each vertex in preorder (the root has depth 0)
+  typedef vector<uint> level_sequence;
+
+  // enumerate all unlabelled free trees with a given number of vertices, each exactly once, by the algorithm of
+  // Wright, Richmond, Odlyzko & McKay: each tree is rooted at its center and represented by its largest level sequence;
+  // the next tree is found by the Beyer-Hedetniemi successor of rooted trees, which changes only the end of the sequence,
+  // jumping over rootings that are not canonical for the free tree
+  class free_tree_enumerator {
+    const uint n;
+    level_sequence level;
+    bool done;
+
+    // the Beyer-Hedetniemi successor, changing the sequence from position p on, return false if there is none
+    bool next_rooted(uint p);
+    // return true iff the current sequence is the canonical one of its free tree and, if not, jump to the next that is
+    bool make_canonical();
+  public:
+    free_tree_enumerator(const uint num_vertices);
+
+    // the current tree
+    inline const level_sequence& get_levels() const { return level; }
+    // return true iff we have not run out of trees yet
+    inline bool valid() const { return !done; }
+    // advance to the next tree, return false if there is none
+    bool next();
+  };
+
+  // convert a level sequence to a flat tree (in preorder, so in topological order)
+  void levels_to_parents(const level_sequence& level, parent_array& parent);
+
+  // level sequences with up to 33 vertices can be packed into 64 bits: going through the vertices in preorder,
+  // we write a 0 for each step up and a 1 for each step down to the next vertex (trailing 0s are omitted)
+  uint64_t encode_levels(const level_sequence& level);
+  void decode_levels(uint64_t code, const uint num_vertices, level_sequence& level);
+
+#define MAX_ENCODED_VERTICES 33
+
+};
+
+#endif
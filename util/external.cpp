@@ -0,0 +1,113 @@
+#include "external.hpp"
+#include <algorithm>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace status {
+
+  parent_block_reader::parent_block_reader(const string filename, const size_t _block_size):
+    fd(open(filename.c_str(), O_RDONLY)), n(0), buffer(_block_size), block_size(_block_size)
+  {
+    if(fd < 0) FAIL("unable to open "<<filename<<" for reading");
+    char header[BINARY_TREE_HEADER];
+    if((pread(fd, header, BINARY_TREE_HEADER, 0) != BINARY_TREE_HEADER) || memcmp(header, BINARY_TREE_MAGIC, 8))
+      FAIL(filename<<" is not a binary tree file");
+    memcpy(&n, header + 8, sizeof(uint64_t));
+  }
+
+  parent_block_reader::~parent_block_reader(){
+    close(fd);
+  }
+
+  const uint* parent_block_reader::read(const uint64_t begin, const uint64_t end, const uint64_t ahead){
+    assert(end - begin <= block_size);
+    if(ahead != NO_AHEAD){
+      const uint64_t ahead_end(min(n, ahead + block_size));
+      posix_fadvise(fd, BINARY_TREE_HEADER + ahead * sizeof(uint), (ahead_end - ahead) * sizeof(uint), POSIX_FADV_WILLNEED);
+    }
+    char* const target((char*)buffer.data());
+    const size_t bytes((end - begin) * sizeof(uint));
+    off_t offset(BINARY_TREE_HEADER + begin * sizeof(uint));
+    // pread may return less than we asked for
+    for(size_t done = 0; done < bytes;){
+      const ssize_t r(pread(fd, target + done, bytes - done, offset + done));
+      if(r <= 0) FAIL("tree file is truncated");
+      done += r;
+    }
+    return buffer.data();
+  }
+
+  // one 64-bit counter per vertex, in memory or in a mapped file
+  class counter_array {
+    uint64_t* data;
+    size_t bytes;
+    vector<uint64_t> in_memory;
+  public:
+    counter_array(const uint64_t n, const string scratch_file): data(NULL), bytes(n * sizeof(uint64_t)) {
+      if(scratch_file.empty()){
+        in_memory.assign(n, 1);
+        data = in_memory.data();
+      } else {
+        const int fd(open(scratch_file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644));
+        if(fd < 0) FAIL("unable to open "<<scratch_file<<" for writing");
+        if(ftruncate(fd, bytes)) FAIL("unable to grow "<<scratch_file<<" to "<<bytes<<" bytes");
+        void* const m(bytes ? mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : NULL);
+        close(fd);
+        if(m == MAP_FAILED) FAIL("unable to map "<<scratch_file);
+        data = (uint64_t*)m;
+        for(uint64_t v = 0; v < n; ++v) data[v] = 1;
+      }
+    }
+    ~counter_array(){ if(in_memory.empty() && bytes) munmap(data, bytes); }
+    inline uint64_t& operator[](const uint64_t v) { return data[v]; }
+    inline uint64_t* begin() { return data; }
+    inline uint64_t* end() { return data + bytes / sizeof(uint64_t); }
+  };
+
+  void external_stati(const string tree_file, const string sequence_file, const string scratch_file){
+    parent_block_reader reader(tree_file);
+    const uint64_t n(reader.size());
+    const uint64_t block(reader.get_block_size());
+    counter_array counter(n, scratch_file);
+
+    // backward sweep: the subtree sizes, the status of the root is the sum of the sizes of the other subtrees
+    uint64_t root_status = 0;
+    for(uint64_t end = n; end > 0;){
+      const uint64_t begin(end > block ? end - block : 0);
+      const uint* const parent(reader.read(begin, end, begin ? (begin > block ? begin - block : 0) : NO_AHEAD));
+      for(uint64_t v = end; v-- > begin;){
+        if(v == 0) break;
+        const uint p(parent[v - begin]);
+        if(p >= v) FAIL(tree_file<<" is not in topological order at vertex "<<v);
+        counter[p] += counter[v];
+        root_status += counter[v];
+      }
+      end = begin;
+    }
+
+    // forward sweep: the status of v from its parent's and the size of its subtree (see stati_sweep::down in tree_view.hpp)
+    if(n) counter[0] = root_status;
+    for(uint64_t begin = 0; begin < n; begin += block){
+      const uint64_t end(min(n, begin + block));
+      const uint* const parent(reader.read(begin, end, end < n ? end : NO_AHEAD));
+      for(uint64_t v = max<uint64_t>(begin, 1); v < end; ++v)
+        counter[v] = counter[parent[v - begin]] + n - 2 * counter[v];
+    }
+
+    // sort the stati and write them as "multiplicity x status"
+    sort(counter.begin(), counter.end());
+    FILE* f(fopen(sequence_file.c_str(), "wb"));
+    if(!f) FAIL("unable to open "<<sequence_file<<" for writing");
+    for(uint64_t i = 0; i < n;){
+      uint64_t j = i + 1;
+      while((j < n) && (counter[j] == counter[i])) ++j;
+      fprintf(f, "%s%lux%lu", i ? " " : "", (unsigned long)(j - i), (unsigned long)counter[i]);
+      i = j;
+    }
+    fputc('\n', f);
+    if(fclose(f)) FAIL("could not write "<<sequence_file);
+  }
+
+};
@@ -0,0 +1,42 @@
+#ifndef EXTERNAL_HPP
+#define EXTERNAL_HPP
+
+#include "defs.hpp"
+#include "flat.hpp"
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+namespace status {
+
+  // read the parents of a binary tree file (see flat.hpp) block by block with pread, in either direction, telling the
+  // kernel to read ahead the next block while we're working on the current one
+  class parent_block_reader {
+    int fd;
+    uint64_t n;
+    vector<uint> buffer;
+    const size_t block_size;
+  public:
+    parent_block_reader(const string filename, const size_t block_size = 1 << 24);
+    ~parent_block_reader();
+
+    inline uint64_t size() const { return n; }
+    // read the parents of the vertices [begin, end) (at most block_size of them) and return a pointer to them;
+    // ahead is the first vertex of the block we're going to read next (or NO_AHEAD)
+    const uint* read(const uint64_t begin, const uint64_t end, const uint64_t ahead);
+    inline size_t get_block_size() const { return block_size; }
+  };
+
+#define NO_AHEAD UINT64_MAX
+
+  // compute the status sequence of a tree in a binary file without loading it: a backward sweep over the file computes the
+  // subtree sizes and a forward sweep turns them into stati (using that parents come before their children), then the
+  // stati are sorted and written to sequence_file in the format of write_sequence_to_file
+  // only one 64-bit counter per vertex is kept; if scratch_file is given, the counters live in this file (mapped into
+  // memory) instead of RAM, so the tree may be larger than the memory
+  void external_stati(const string tree_file, const string sequence_file, const string scratch_file = "");
+
+};
+
+#endif
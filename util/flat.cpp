@@ -0,0 +1,208 @@
+#include "flat.hpp"
+#include <string.h>
+
+namespace status {
+
+  tree* parents_to_tree(const parent_array& parent){
+    tree* t = new tree();
+    if(parent.empty()) return t;
+    vector<vertex*> vertex_nr(parent.size());
+    vertex_nr[0] = t->add_vertex(NULL);
+    for(size_t i = 1; i < parent.size(); ++i){
+      assert(parent[i] < i);
+      vertex_nr[i] = t->add_vertex(vertex_nr[parent[i]]);
+    }
+    return t;
+  }
+
+  void subtree_to_parents(const vertex* const root, parent_array& parent, vector<const vertex*>* vertices){
+    // the BFS queue is the list of vertices in order of their names, so it's never popped
+    vector<const vertex*> own_queue;
+    vector<const vertex*>& queue(vertices ? *vertices : own_queue);
+    queue.clear();
+    queue.push_back(root);
+    parent.assign(1, NO_PARENT);
+    for(size_t i = 0; i < queue.size(); ++i)
+      for(const vertex* child : queue[i]->get_children()){
+        queue.push_back(child);
+        parent.push_back(i);
+      }
+  }
+
+  void tree_to_parents(const tree& t, parent_array& parent, vector<const vertex*>* vertices){
+    parent.clear();
+    if(vertices) vertices->clear();
+    if(t.empty()) return;
+    parent.reserve(t.get_size());
+    if(vertices) vertices->reserve(t.get_size());
+    subtree_to_parents(t.get_root(), parent, vertices);
+  }
+
+  uint compute_centroid(const parent_array& parent){
+    const uint n(parent.size());
+    if(!n) return NO_PARENT;
+    vector<uint> size(n, 1);
+    // the subtree sizes bottom-up, remembering the child with more than half of the vertices, if any
+    vector<uint> heavy_child(n, NO_PARENT);
+    for(uint v = n; v-- > 1;){
+      size[parent[v]] += size[v];
+      if(2 * size[v] > n) heavy_child[parent[v]] = v;
+    }
+    uint v = 0;
+    while(heavy_child[v] != NO_PARENT) v = heavy_child[v];
+    return v;
+  }
+
+  void reroot_parents(parent_array& parent, const uint new_root){
+    uint previous = NO_PARENT;
+    for(uint v = new_root; v != NO_PARENT;){
+      const uint next(parent[v]);
+      parent[v] = previous;
+      previous = v;
+      v = next;
+    }
+  }
+
+  uint caterpillar_recognizer::recognize(const parent_array& parent, vector<uint>* backbone, vector<uint>* leaves){
+    const uint n(parent.size());
+    if(backbone) backbone->clear();
+    if(leaves) leaves->clear();
+    if(n <= 2){
+      // one vertex with all others as leaves
+      if(n){
+        if(backbone) backbone->push_back(0);
+        if(leaves) leaves->push_back(n - 1);
+      }
+      return n ? 1 : 0;
+    }
+    degree.assign(n, 0);
+    for(uint v = 0; v < n; ++v) if(parent[v] != NO_PARENT){
+      ++degree[v];
+      ++degree[parent[v]];
+    }
+    // the non-leaf vertices of a tree induce a subtree, which is a path iff each of them has at most two non-leaf neighbors
+    neighbors.resize(2 * n);
+    num_neighbors.assign(n, 0);
+    uint end = NO_PARENT;
+    for(uint v = 0; v < n; ++v){
+      const uint p(parent[v]);
+      if((p != NO_PARENT) && (degree[v] > 1) && (degree[p] > 1)){
+        if((num_neighbors[v] == 2) || (num_neighbors[p] == 2)) return NOT_A_CATERPILLAR;
+        neighbors[2 * v + num_neighbors[v]++] = p;
+        neighbors[2 * p + num_neighbors[p]++] = v;
+      }
+    }
+    uint length = 0;
+    for(uint v = 0; v < n; ++v) if(degree[v] > 1){
+      ++length;
+      if(num_neighbors[v] < 2) end = v;
+    }
+    // walk along the backbone from one end to the other
+    if(backbone || leaves){
+      uint previous = NO_PARENT;
+      for(uint v = end; v != NO_PARENT;){
+        if(backbone) backbone->push_back(v);
+        if(leaves) leaves->push_back(degree[v] - num_neighbors[v]);
+        uint next = NO_PARENT;
+        for(uint i = 0; i < num_neighbors[v]; ++i) if(neighbors[2 * v + i] != previous) next = neighbors[2 * v + i];
+        previous = v;
+        v = next;
+      }
+    }
+    return length;
+  }
+
+  void caterpillar_recognizer::classify(const vector<parent_array>& trees, vector<uint>& result){
+    result.resize(trees.size());
+    for(size_t i = 0; i < trees.size(); ++i) result[i] = recognize(trees[i]);
+  }
+
+  // ====================== writing =============================
+
+  const size_t writer_buffer_size(1 << 20);
+
+  parent_writer::parent_writer(const string filename, const size_t num_vertices, const bool _binary):
+    f(fopen(filename.c_str(), "wb")), binary(_binary), next_vertex(0), buffer(writer_buffer_size + 32), used(0)
+  {
+    if(!f) FAIL("unable to open "<<filename<<" for writing");
+    if(binary){
+      const uint64_t n(num_vertices);
+      fwrite(BINARY_TREE_MAGIC, 1, 8, f);
+      fwrite(&n, sizeof(uint64_t), 1, f);
+    }
+  }
+
+  parent_writer::~parent_writer(){
+    flush();
+    fclose(f);
+  }
+
+  void parent_writer::flush(){
+    if(used && (fwrite(buffer.data(), 1, used, f) != used)) FAIL("could not write tree");
+    used = 0;
+  }
+
+  void parent_writer::push(const uint parent){
+    assert((next_vertex == 0) == (parent == NO_PARENT));
+    assert((next_vertex == 0) || (parent < next_vertex));
+    if(binary){
+      memcpy(&buffer[used], &parent, sizeof(uint));
+      used += sizeof(uint);
+    } else if(next_vertex){
+      used = print_uint(buffer.data(), used, parent);
+      buffer[used++] = ' ';
+      used = print_uint(buffer.data(), used, next_vertex);
+      buffer[used++] = '\n';
+    }
+    ++next_vertex;
+    if(used >= writer_buffer_size) flush();
+  }
+
+  bool is_binary_tree_name(const string& filename){
+    return (filename.size() >= 4) && (filename.compare(filename.size() - 4, 4, ".bin") == 0);
+  }
+
+  void write_parents(const parent_array& parent, const string filename){
+    parent_writer w(filename, parent.size(), is_binary_tree_name(filename));
+    w.push(parent);
+  }
+
+  // ====================== reading =============================
+
+  void read_parents(const string filename, parent_array& parent){
+    FILE* f(fopen(filename.c_str(), "rb"));
+    if(!f) FAIL("unable to open "<<filename<<" for reading");
+    parent.clear();
+
+    char magic[8];
+    uint64_t n;
+    if((fread(magic, 1, 8, f) == 8) && !memcmp(magic, BINARY_TREE_MAGIC, 8)){
+      if(fread(&n, sizeof(uint64_t), 1, f) != 1) FAIL(filename<<" is truncated");
+      parent.resize(n);
+      if(fread(parent.data(), sizeof(uint), n, f) != n) FAIL(filename<<" is truncated");
+    } else {
+      // in text, the vertices may have any names, the first name we see is the root and children are named when we see them
+      rewind(f);
+      vector<uint> index_of;
+      uint u, v;
+      while(fscanf(f, "%u %u", &u, &v) == 2){
+        if(max(u, v) >= index_of.size()) index_of.resize(max<size_t>(max(u, v) + 1, 2 * index_of.size()), NO_PARENT);
+        if(parent.empty()){
+          index_of[u] = 0;
+          parent.push_back(NO_PARENT);
+        }
+        if(index_of[u] == NO_PARENT) FAIL(filename<<" is not in topological order: "<<u<<" used before it is named");
+        index_of[v] = parent.size();
+        parent.push_back(index_of[u]);
+      }
+    }
+    fclose(f);
+  }
+
+  tree* read_tree(const string filename){
+    parent_array parent;
+    read_parents(filename, parent);
+    return parents_to_tree(parent);
+  }
+
+};
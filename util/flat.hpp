@@ -0,0 +1,93 @@
+#ifndef FLAT_HPP
+#define FLAT_HPP
+
+#include "defs.hpp"
+#include "graphs.hpp"
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+namespace status {
+
+  // a flat tree gives the parent of each vertex, vertex 0 is the root and its entry is NO_PARENT;
+  // all of our flat trees are in topological order, that is, each parent is smaller than its children
+  typedef vector<uint> parent_array;
+
+#define NO_PARENT UINT_MAX
+
+  // convert between pointer trees and flat trees (the flat tree is in BFS order);
+  // if vertices is given, it receives the vertex of each index of the flat tree
+  tree* parents_to_tree(const parent_array& parent);
+  void subtree_to_parents(const vertex* const root, parent_array& parent, vector<const vertex*>* vertices = NULL);
+  void tree_to_parents(const tree& t, parent_array& parent, vector<const vertex*>* vertices = NULL);
+
+  // compute a vertex of minimum status (a centroid) from the subtree sizes
+  uint compute_centroid(const parent_array& parent);
+  // reroot the flat tree at new_root by turning around the parents on the path from the root to new_root, in time linear
+  // in its length; the result is no longer in topological order (the root is new_root instead of 0)
+  void reroot_parents(parent_array& parent, const uint new_root);
+
+  // recognize caterpillars among many flat trees (in any order, the root has NO_PARENT), reusing the scratch space
+  // the encoding is the same as that of recognize_caterpillar: the backbone and the number of leaves at each of its vertices
+  class caterpillar_recognizer {
+    vector<uint> degree;
+    // the (at most two) non-leaf neighbors of each non-leaf vertex
+    vector<uint> neighbors;
+    vector<unsigned char> num_neighbors;
+  public:
+    // return the length of the backbone, or NOT_A_CATERPILLAR; backbone and leaves are each only filled if given
+    uint recognize(const parent_array& parent, vector<uint>* backbone = NULL, vector<uint>* leaves = NULL);
+    // classify many trees: result[i] is the length of the backbone of trees[i] or NOT_A_CATERPILLAR
+    void classify(const vector<parent_array>& trees, vector<uint>& result);
+  };
+
+  // a tree can be stored in two formats:
+  // 1. text: one edge "parent child" per line, as written by tree::write_to_file
+  // 2. binary: the magic, the number of vertices as uint64 and then the parent of each vertex as uint32 (all little endian)
+#define BINARY_TREE_MAGIC "STATTREE"
+#define BINARY_TREE_HEADER 16
+
+  // print x into the buffer at pos (which has room for 10 more digits) and return the new pos, for our writers
+  inline size_t print_uint(char* const buffer, size_t pos, uint x){
+    char digits[10];
+    uint len = 0;
+    do { digits[len++] = '0' + (x % 10); x /= 10; } while(x);
+    while(len) buffer[pos++] = digits[--len];
+    return pos;
+  }
+
+  // write a tree vertex by vertex so that it never has to be in memory
+  class parent_writer {
+    FILE* f;
+    const bool binary;
+    size_t next_vertex;
+    // our own buffer, formatting numbers into it is much faster than going through the streams
+    vector<char> buffer;
+    size_t used;
+
+    void flush();
+  public:
+    parent_writer(const string filename, const size_t num_vertices, const bool binary);
+    ~parent_writer();
+    // append the next vertex (it has to be smaller than the parent), the root is pushed with NO_PARENT
+    void push(const uint parent);
+    inline void push(const parent_array& parent) { for(uint p : parent) push(p); }
+    // return the number of vertices written so far
+    inline size_t size() const { return next_vertex; }
+  };
+
+  // write a flat tree in one of the formats (binary iff the filename ends in ".bin")
+  void write_parents(const parent_array& parent, const string filename);
+  // read a flat tree in any of the formats
+  void read_parents(const string filename, parent_array& parent);
+  // return true iff the filename denotes a binary tree
+  bool is_binary_tree_name(const string& filename);
+
+  // read a pointer tree in any of the formats
+  tree* read_tree(const string filename);
+
+};
+
+#endif
@@ -0,0 +1,191 @@
+#include "generate.hpp"
+#include <algorithm> // for shuffle()
+
+namespace status {
+
+  // the number of vertices that the streaming generators draw at once
+  const size_t stream_window(64 * random_chunk_size);
+
+  void random_recursive_parents(const size_t num_vertices, const uint64_t seed, parent_array& parent){
+    parent.resize(num_vertices);
+    if(!num_vertices) return;
+    parent[0] = NO_PARENT;
+    parallel_draw(num_vertices, seed, [&](const size_t begin, const size_t end, rng& r){
+      for(size_t i = max<size_t>(begin, 1); i < end; ++i) parent[i] = r.below(i);
+    });
+  }
+
+  void stream_random_recursive(const size_t num_vertices, const uint64_t seed, parent_writer& w){
+    parent_array window(stream_window);
+    for(size_t begin = 0; begin < num_vertices; begin += stream_window){
+      const size_t end(min(num_vertices, begin + stream_window));
+      parallel_draw(begin, end, seed, [&](const size_t chunk_begin, const size_t chunk_end, rng& r){
+        for(size_t i = max<size_t>(chunk_begin, 1); i < chunk_end; ++i) window[i - begin] = r.below(i);
+      });
+      if(!begin) window[0] = NO_PARENT;
+      for(size_t i = begin; i < end; ++i) w.push(window[i - begin]);
+    }
+  }
+
+  void random_uniform_parents(const size_t num_vertices, const uint64_t seed, parent_array& parent){
+    parent.clear();
+    if(num_vertices <= 2){
+      for(size_t i = 0; i < num_vertices; ++i) parent.push_back(i ? 0 : NO_PARENT);
+      return;
+    }
+    // 1. draw a Pruefer sequence
+    vector<uint> pruefer(num_vertices - 2);
+    parallel_draw(pruefer.size(), seed, [&](const size_t begin, const size_t end, rng& r){
+      for(size_t i = begin; i < end; ++i) pruefer[i] = r.below(num_vertices);
+    });
+
+    // 2. decode it in linear time: always cut the smallest leaf, but only scan forward for the next leaf if the vertex that
+    //    just became a leaf is larger than the scan pointer; this gives a tree rooted at num_vertices-1, 'up' are the parents
+    vector<uint> degree(num_vertices + 1, 1);
+    for(uint x : pruefer) ++degree[x];
+    vector<uint> up(num_vertices);
+    size_t ptr = 0;
+    while(degree[ptr] != 1) ++ptr;
+    uint leaf = ptr;
+    for(uint x : pruefer){
+      up[leaf] = x;
+      if((--degree[x] == 1) && (x < ptr)) leaf = x; else {
+        while(degree[++ptr] != 1);
+        leaf = ptr;
+      }
+    }
+    const uint root(num_vertices - 1);
+    up[leaf] = root;
+    up[root] = NO_PARENT;
+    vector<uint>().swap(pruefer);
+
+    // 3. relabel in BFS order from the root: collect the children in CSR (reusing degree for the offsets)
+    vector<uint>& offset(degree);
+    fill(offset.begin(), offset.end(), 0);
+    for(size_t v = 0; v < num_vertices; ++v) if(v != root) ++offset[up[v] + 1];
+    for(size_t v = 0; v < num_vertices; ++v) offset[v + 1] += offset[v];
+    vector<uint> children(num_vertices - 1);
+    for(size_t v = 0; v < num_vertices; ++v) if(v != root) children[offset[up[v]]++] = v;
+    // offset[v] now points to the end of the children of v, they start at the end of the children of v-1
+    parent.resize(num_vertices);
+    vector<uint> queue(1, root);
+    queue.reserve(num_vertices);
+    parent[0] = NO_PARENT;
+    for(size_t i = 0; i < queue.size(); ++i){
+      const uint v(queue[i]);
+      for(uint j = (v ? offset[v - 1] : 0); j < offset[v]; ++j){
+        parent[queue.size()] = i;
+        queue.push_back(children[j]);
+      }
+    }
+  }
+
+#define percentage_backbone 30
+  // draw the size of the backbone of a caterpillar
+  inline size_t draw_backbone(const size_t num_vertices, rng& r){
+    const size_t num_backbone = uint(num_vertices*percentage_backbone/100) + r.below(uint(num_vertices*(100-percentage_backbone)/100));
+    DEBUG3(cout << "selected "<<num_backbone<<" vertices for backbone" << endl);
+    return max<size_t>(num_backbone, 1);
+  }
+
+  void random_caterpillar_parents(const size_t num_vertices, const uint64_t seed, parent_array& parent){
+    parent.resize(num_vertices);
+    if(!num_vertices) return;
+    rng r(seed, sequential_stream);
+    // create backbone
+    const size_t num_backbone(draw_backbone(num_vertices, r));
+    parent[0] = NO_PARENT;
+    for(size_t i = 1; i < num_backbone; ++i) parent[i] = i - 1;
+    // create leaves, drawing their backbone vertices in parallel
+    parallel_draw(num_vertices - num_backbone, seed, [&](const size_t begin, const size_t end, rng& r){
+      for(size_t i = begin; i < end; ++i) parent[num_backbone + i] = r.below(num_backbone);
+    });
+  }
+
+  void stream_random_caterpillar(const size_t num_vertices, const uint64_t seed, parent_writer& w){
+    if(!num_vertices) return;
+    rng r(seed, sequential_stream);
+    const size_t num_backbone(draw_backbone(num_vertices, r));
+    w.push(NO_PARENT);
+    for(size_t i = 1; i < num_backbone; ++i) w.push(i - 1);
+    parent_array window(stream_window);
+    const size_t num_leaves(num_vertices - num_backbone);
+    for(size_t begin = 0; begin < num_leaves; begin += stream_window){
+      const size_t end(min(num_leaves, begin + stream_window));
+      parallel_draw(begin, end, seed, [&](const size_t chunk_begin, const size_t chunk_end, rng& r){
+        for(size_t i = chunk_begin; i < chunk_end; ++i) window[i - begin] = r.below(num_backbone);
+      });
+      for(size_t i = begin; i < end; ++i) w.push(window[i - begin]);
+    }
+  }
+
+  void random_sparse_caterpillar_parents(const size_t num_vertices, const uint64_t seed, parent_array& parent){
+    parent.resize(num_vertices);
+    if(!num_vertices) return;
+    rng r(seed, sequential_stream);
+    // create backbone using at least half the vertices
+    const size_t num_backbone = uint((num_vertices+1)/2) + r.below(uint(num_vertices/3));
+    DEBUG3(cout << "selected "<<num_backbone<<" vertices for backbone" << endl);
+    parent[0] = NO_PARENT;
+    for(size_t i = 1; i < num_backbone; ++i) parent[i] = i - 1;
+    // shuffle backbone vertices
+    vector<uint> backbone(num_backbone);
+    for(size_t i = 0; i < num_backbone; ++i) backbone[i] = i;
+    std::shuffle(backbone.begin(), backbone.end(), r);
+    // give one leaf to each of the first backbone vertices (since leaves < n/2, some bb vertices don't get leaves)
+    for(size_t i = num_backbone; i < num_vertices; ++i) parent[i] = backbone[i - num_backbone];
+  }
+
+  sequence_mutator::sequence_mutator(const sequence_t& s, const uint64_t seed):
+    center(UINT_MAX, 0), num_vertices(get_num_vertices(s)), r(seed, sequential_stream)
+  {
+    for(const sequence_t::value_type& entry : s)
+      if(entry.first < center.first) center = entry;
+    base.reserve(s.size());
+    for(const sequence_t::value_type& entry : s)
+      if(entry.first != center.first) base.push_back(entry);
+    // the iteration order of s is not under our control, so sort to be reproducible
+    sort(base.begin(), base.end());
+    current = base;
+  }
+
+  void sequence_mutator::merge_once(){
+    const size_t m(current.size());
+    if(m < 2) return;
+    // get two different coordinates to merge
+    const size_t x(r.below(m));
+    size_t y(r.below(m - 1));
+    if(y >= x) ++y;
+    // transfer all occurances of the x'th status to the y'th status and remove the x'th
+    current[y].second += current[x].second;
+    current[x] = current.back();
+    current.pop_back();
+  }
+
+  void sequence_mutator::merge_until(const double avg_multi){
+    while((num_vertices < avg_multi * (current.size() + 1)) && (current.size() > 1)) merge_once();
+  }
+
+  void sequence_mutator::get_sequence(sequence_t& s) const{
+    s.clear();
+    s.reserve(current.size() + 1);
+    if(center.second) s.insert(center);
+    s.insert(current.begin(), current.end());
+  }
+
+  // get a random sequence of given length and average multiplicity
+  sequence_t get_random_sequence(const uint num_vertices, const double avg_multi, const uint64_t seed){
+    // create a caterpillar of num_vertices vertices, compute its status sequence
+    // and change stati into existing stati until the avg multiplicity is reached
+    tree* t = get_random_caterpillar(num_vertices, seed);
+    sequence_t s(compute_stati(*t));
+    t->clear();
+    delete t;
+
+    // don't reuse the caterpillar's stream
+    sequence_mutator mutator(s, mix64(seed));
+    mutator.next(avg_multi, s);
+    return s;
+  }
+
+};
@@ -0,0 +1,105 @@
+#ifndef GENERATE_HPP
+#define GENERATE_HPP
+
+#include "defs.hpp"
+#include "graphs.hpp"
+#include "seq.hpp"
+#include "flat.hpp"
+#include "random.hpp"
+
+namespace status {
+
+  // all generators are deterministic in their seed: the same seed always gives the same tree/sequence
+
+  // the stream of a seed that the generators use for their sequential draws (parallel draws use streams 0, 1, ...)
+  const uint64_t sequential_stream(UINT64_MAX);
+
+  // ==================== flat generators =========================
+  // these never create pointer vertices, so they go to billions of vertices (up to UINT_MAX)
+
+  // uniformly random labelled tree, decoding a random Pruefer sequence in linear time (in BFS order)
+  void random_uniform_parents(const size_t num_vertices, const uint64_t seed, parent_array& parent);
+  // random recursive tree: each vertex is attached to a uniformly chosen smaller one
+  void random_recursive_parents(const size_t num_vertices, const uint64_t seed, parent_array& parent);
+  // random caterpillar: a backbone of 30-100% of the vertices and the others attached to random backbone vertices
+  void random_caterpillar_parents(const size_t num_vertices, const uint64_t seed, parent_array& parent);
+  // random caterpillar whose backbone vertices have between 0 and 1 leaves
+  void random_sparse_caterpillar_parents(const size_t num_vertices, const uint64_t seed, parent_array& parent);
+
+  // write random recursive trees and caterpillars straight to disk without ever holding them in memory
+  // (these write the same trees as the above)
+  void stream_random_recursive(const size_t num_vertices, const uint64_t seed, parent_writer& w);
+  void stream_random_caterpillar(const size_t num_vertices, const uint64_t seed, parent_writer& w);
+
+  // ==================== pointer generators =======================
+
+  // create a random tree by attaching each new vertex to a uniformly chosen existing one
+  inline tree* get_random_tree(const size_t num_vertices, const uint64_t seed){
+    parent_array parent;
+    random_recursive_parents(num_vertices, seed, parent);
+    return parents_to_tree(parent);
+  }
+
+  // create a uniformly random labelled tree
+  inline tree* get_random_uniform_tree(const size_t num_vertices, const uint64_t seed){
+    parent_array parent;
+    random_uniform_parents(num_vertices, seed, parent);
+    return parents_to_tree(parent);
+  }
+
+  // create a random caterpillar
+  inline tree* get_random_caterpillar(const size_t num_vertices, const uint64_t seed){
+    parent_array parent;
+    random_caterpillar_parents(num_vertices, seed, parent);
+    return parents_to_tree(parent);
+  }
+
+  // get a random caterpillar whose backbone vertices have between 0 and 1 leaves
+  inline tree* get_random_sparse_caterpillar(const size_t num_vertices, const uint64_t seed){
+    parent_array parent;
+    random_sparse_caterpillar_parents(num_vertices, seed, parent);
+    return parents_to_tree(parent);
+  }
+
+  // ==================== sequence generators =======================
+
+  // perturbs a status sequence by merging stati (moving all occurances of one status onto another) until it reaches a
+  // target average multiplicity; the center status (the smallest) is kept aside and never touched
+  // the other stati are kept in a vector so that drawing one is O(1) and removing one is a swap with the last,
+  // thus each merge costs O(1) and each perturbed sequence O(#stati)
+  class sequence_mutator {
+    // the sequence to perturb and the current perturbation, both without the center
+    vector<pair<uint, uint> > base;
+    vector<pair<uint, uint> > current;
+    pair<uint, uint> center;
+    uint num_vertices;
+    rng r;
+
+  public:
+    sequence_mutator(const sequence_t& s, const uint64_t seed);
+
+    // start over from the base sequence
+    inline void reset() { current = base; }
+    // merge a random status into another random status (if there are two stati left besides the center)
+    void merge_once();
+    // merge until the average multiplicity (including the center) is at least avg_multi
+    void merge_until(const double avg_multi);
+
+    // return the current average multiplicity
+    inline double avg_multiplicity() const { return double(num_vertices) / (current.size() + 1); }
+    // get the current sequence
+    void get_sequence(sequence_t& s) const;
+    // get the next perturbation of the base sequence with the given average multiplicity
+    inline void next(const double avg_multi, sequence_t& s){
+      reset();
+      merge_until(avg_multi);
+      get_sequence(s);
+    }
+  };
+
+  // get a random sequence of given length and average multiplicity
+  sequence_t get_random_sequence(const uint num_vertices, const double avg_multi, const uint64_t seed);
+
+};
+
+#endif
@@ -1,6 +1,8 @@
 #include "graphs.hpp"
+#include "canon.hpp"
 #include <unordered_map>
 #include <sstream>
+#include <algorithm>
 
 namespace status{
 
@@ -132,18 +134,19 @@ namespace status{
   
   void tree::reroot(vertex* const new_root){
     assert(new_root != NULL);
-    // make sure we're not already at the correct root
-    vertex* const parent(new_root->get_parent());
-    if(parent){
-      // make the parent new root
-      reroot(parent);
-      // and change places with the parent
-      parent->remove_child(new_root);
-      parent->set_parent(new_root);
-      new_root->add_child(parent);
-      new_root->set_parent(NULL);
-      root = new_root;
+    // collect the path from new_root up to the old root
+    vector<vertex*> path;
+    for(vertex* v = new_root; v; v = v->get_parent()) path.push_back(v);
+    // turn around the edges on the path, starting at the old root
+    for(size_t i = path.size() - 1; i > 0; --i){
+      vertex* const parent(path[i]);
+      vertex* const child(path[i - 1]);
+      parent->remove_child(child);
+      child->add_child(parent);
+      parent->set_parent(child);
     }
+    new_root->set_parent(NULL);
+    root = new_root;
   }
 
   // copy a tree and give a map resolving the old vertices to the new vertices
@@ -232,47 +235,112 @@ namespace status{
   }
 
 
-  // return whether the subtrees rooted at u and v are isomorph
-  bool subtrees_isomorph(const vertex* const u, const vertex* const v){
-    const list<vertex*>& u_childs(u->get_children());
-    const list<vertex*>& v_childs(v->get_children());
-    
-    if(u_childs.size() == v_childs.size()){
-//      auto ui = u_childs.begin();
-//      TODO
-    } else return false;
-    return true;
-  }
-
-  void tree::merge_automorphism_classes(){
-  }
-
-  // return a list of non-leaf children
-  inline const list<vertex*> vertex::get_non_leaf_children() const{
-    list<vertex*> l;
-    for(vertex* c : children) if(!c->is_leaf()) l.push_back(c);
-    return l;
+  // number the orbits of the vertices under the automorphisms fixing the root (the root is orbit 0), write the orbit of
+  // each vertex to cls and return the number of orbits
+  uint tree::merge_automorphism_classes(unordered_map<const vertex*, uint>& cls) const{
+    cls.clear();
+    if(empty()) return 0;
+    parent_array parent;
+    vector<const vertex*> vertices;
+    vector<uint> subtree_cls;
+    tree_to_parents(*this, parent, &vertices);
+    subtree_classes(parent, subtree_cls);
+    // top-down, two vertices are in the same orbit iff their parents are and their subtrees are isomorphic
+    vector<uint> orbit(parent.size());
+    unordered_map<uint64_t, uint> orbit_of;
+    orbit[0] = 0;
+    cls[vertices[0]] = 0;
+    for(size_t v = 1; v < parent.size(); ++v){
+      const uint64_t key(((uint64_t)orbit[parent[v]] << 32) | subtree_cls[v]);
+      orbit[v] = orbit_of.insert(make_pair(key, (uint)orbit_of.size() + 1)).first->second;
+      cls[vertices[v]] = orbit[v];
+    }
+    return orbit_of.size() + 1;
   }
 
   // return true iff replacing v's parent by a P2 still yields a caterpillar
   bool subtree_is_caterpillar(const vertex* v){
     assert(v != NULL);
-    list<vertex*> l = v->get_non_leaf_children();
-    if(l.empty()) return true;
-    if(l.size() > 1) return false;
-    return subtree_is_caterpillar(l.front());
+    // walk down as long as there is exactly one non-leaf child
+    while(v){
+      const vertex* next = NULL;
+      for(const vertex* c : v->get_children())
+        if(!c->is_leaf()){
+          if(next) return false;
+          next = c;
+        }
+      v = next;
+    }
+    return true;
   }
   // return true iff t is a caterpillar
   bool detect_caterpillar(const tree& t){
     // an empty tree is a caterpillar
     if(t.empty()) return true;
-    // get the non-leaf neighbors of the root
-    list<vertex*> l = t.get_root()->get_non_leaf_children();
-    if(l.empty()) return true;
-    if(l.size() > 2) return false;
-    bool tmp = subtree_is_caterpillar(l.front());
-    bool tmp2 = subtree_is_caterpillar(l.back());
-    return tmp && tmp2;
+    // if the root has only one child, it is a leaf of this child, which may then have two non-leaf children
+    const vertex* top(t.get_root());
+    if(top->get_children().size() == 1) top = top->get_children().front();
+    // the top may have up to two non-leaf children, each of which starts a caterpillar
+    uint non_leaf_children = 0;
+    for(const vertex* c : top->get_children())
+      if(!c->is_leaf()){
+        if(++non_leaf_children > 2) return false;
+        if(!subtree_is_caterpillar(c)) return false;
+      }
+    return true;
+  }
+
+  uint recognize_caterpillar(const tree& t, uint* const backbone, uint* const leaves){
+    if(t.empty()) return 0;
+    // if the root has only one child, it is a leaf of this child, which may then have two non-leaf children
+    const vertex* top(t.get_root());
+    uint top_leaves = 0;
+    if((top->get_children().size() == 1) && !top->get_children().front()->is_leaf()){
+      top = top->get_children().front();
+      top_leaves = 1;
+    }
+    const vertex* side[2] = {NULL, NULL};
+    for(const vertex* c : top->get_children())
+      if(c->is_leaf()) ++top_leaves;
+      else if(side[1]) return NOT_A_CATERPILLAR;
+      else side[side[0] ? 1 : 0] = c;
+
+    // walk down one side of the backbone starting at v, appending to backbone and leaves
+    uint length = 0;
+    auto walk = [&](const vertex* v) -> bool {
+      while(v){
+        const vertex* next = NULL;
+        backbone[length] = v->get_id();
+        leaves[length] = 0;
+        for(const vertex* c : v->get_children())
+          if(c->is_leaf()) ++leaves[length];
+          else if(next) return false;
+          else next = c;
+        ++length;
+        v = next;
+      }
+      return true;
+    };
+    // the first side is written from the top on and then turned around, so the backbone goes from end to end
+    if(side[0]){
+      if(!walk(side[0])) return NOT_A_CATERPILLAR;
+      reverse(backbone, backbone + length);
+      reverse(leaves, leaves + length);
+    }
+    backbone[length] = top->get_id();
+    leaves[length++] = top_leaves;
+    if(side[1] && !walk(side[1])) return NOT_A_CATERPILLAR;
+    return length;
+  }
+
+  tree* caterpillar_from_leaves(const uint* const leaves, const uint length){
+    tree* const result(new tree());
+    vertex* v(NULL);
+    for(uint i = 0; i < length; ++i){
+      v = result->add_vertex(v);
+      for(uint j = 0; j < leaves[i]; ++j) result->add_vertex(v);
+    }
+    return result;
   }
 
 };
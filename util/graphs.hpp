@@ -34,11 +34,16 @@ namespace status {
     // infrastructure
     vertex* parent;
     list<vertex*> children;
+    // where we are in the children of our parent, so we can be removed from there in constant time
+    list<vertex*>::iterator position;
+    // our number in the tree, see tree::add_vertex
+    uint id;
 
+    friend class tree;
   public:
     // ==================== constructors =========================
-    vertex(vertex* _parent = NULL):data(NULL),parent(_parent),children(){}
-    vertex(vertex* _parent, void* _data):data(_data),parent(_parent),children(){}
+    vertex(vertex* _parent = NULL):data(NULL),parent(_parent),children(),id(0){}
+    vertex(vertex* _parent, void* _data):data(_data),parent(_parent),children(),id(0){}
     ~vertex(){ for(auto c: children) delete c; }
 
     // ================== data interaction =======================
@@ -46,6 +51,7 @@ namespace status {
     inline vertex* const get_parent() const { return parent; }
     inline void set_parent(vertex* const _parent) { parent = _parent; }
     inline void* get_data() const { return data; }
+    inline uint get_id() const { return id; }
     inline void set_data(void* _data) { assert(data == NULL); data = _data; }
     // clear the data in this vertex
     void clear_data() { if(data) { free(data); data = NULL; } }
@@ -59,19 +65,20 @@ namespace status {
     inline bool is_root() const  { return parent == NULL; }
     inline uint degree() const { return children.size() + (parent == NULL ? 0 : 1); }
     inline bool is_leaf() const  { return children.empty(); }
+    // return the next child of our parent after us, or NULL if we're the last (or the root)
+    inline vertex* next_sibling() const {
+      if(!parent) return NULL;
+      auto i(position);
+      return (++i == parent->children.end()) ? NULL : *i;
+    }
 
     // get the children
     inline const list<vertex*>& get_children() const { return children; }
-    // return a list of non-leaf children
-    inline const list<vertex*> get_non_leaf_children() const;
-    inline void add_child(vertex* const child) { children.push_back(child); }
+    inline void add_child(vertex* const child) { child->position = children.insert(children.end(), child); }
     inline void remove_child(const list<vertex*>::iterator i) { children.erase(i); }
     inline void remove_child(const vertex* const child) {
-      // first, find the child
-      auto w = children.begin();
-      for(; *w != child; ++w) assert(w != children.end());
-      // then remove it
-      remove_child(w);
+      assert(child->parent == this);
+      remove_child(child->position);
     }
 
     // create new child and append it to children
@@ -113,20 +120,35 @@ namespace status {
   private:
     uint size;
     vertex* root;
-
+    // the vertices of a tree are numbered 0 to size-1 in the order they are added, so per-vertex values can be kept in
+    // arrays; the numbers do not change, except that removing a vertex gives its number to the vertex with the largest
+    // number (see remove_leaf)
+    vector<vertex*> vertex_by_id;
+
+    inline void register_vertex(vertex* const v){
+      v->id = vertex_by_id.size();
+      vertex_by_id.push_back(v);
+    }
   public:
     // ==================== constructors =========================
-    tree(vertex* _root = NULL):size(_root?1:0),root(_root){}
+    tree(vertex* _root = NULL):size(_root?1:0),root(_root){ if(root) register_vertex(root); }
     
     // ================== data interaction =======================
     // get the size of the tree
     inline uint get_size() const { return size; }
     // get the root
     inline vertex* get_root() const { return root; }
+    // get the vertex with the given number
+    inline vertex* get_vertex(const uint id) const { return vertex_by_id[id]; }
     // clear the custom data in the tree
     inline void clear_data() const { if(root) root->clear_data_subtree(); }
     // clear the vertices
-    inline void clear_vertices() { if(root) delete root; }
+    inline void clear_vertices() {
+      if(root) delete root;
+      root = NULL;
+      size = 0;
+      vertex_by_id.clear();
+    }
     // clear all the tree
     inline void clear() { clear_data(); clear_vertices(); }
     // return true iff the tree is empty
@@ -139,19 +161,43 @@ namespace status {
         if(root) return add_vertex(root, data);
         size = 1;
         root = new vertex(NULL, data);
+        register_vertex(root);
         return root;
       } else {
         ++size;
-        return parent->add_child(data);
+        vertex* const v(parent->add_child(data));
+        register_vertex(v);
+        return v;
       }
     }
     inline vertex* add_vertex(){ return add_vertex(NULL); }
+    // remove a leaf that is not the root (and its data)
+    void remove_leaf(vertex* const leaf){
+      assert(leaf->is_leaf() && !leaf->is_root());
+      leaf->get_parent()->remove_child(leaf);
+      // the last vertex takes the number of the leaf
+      vertex* const last(vertex_by_id.back());
+      last->id = leaf->id;
+      vertex_by_id[leaf->id] = last;
+      vertex_by_id.pop_back();
+      leaf->clear_data();
+      delete leaf;
+      --size;
+    }
+    // hang the subtree of v (which is not the root) below new_parent (which must not be in the subtree of v)
+    void move_subtree(vertex* const v, vertex* const new_parent){
+      assert(!v->is_root());
+      v->get_parent()->remove_child(v);
+      new_parent->add_child(v);
+      v->set_parent(new_parent);
+    }
 
-    // reroot the tree at new_root
+    // reroot the tree at new_root, in time linear in the length of the path from the old root to new_root
     void reroot(vertex* const new_root);
 
-    // merge equivalence classes under automorphism
-    void merge_automorphism_classes();
+    // merge equivalence classes under automorphism: two vertices get the same class iff an automorphism fixing the root
+    // maps one onto the other; the classes are numbered from 0 and the number of classes is returned
+    uint merge_automorphism_classes(unordered_map<const vertex*, uint>& cls) const;
 
     void write_to_file(const string filename);
     void read_from_file(const string filename);
@@ -168,6 +214,16 @@ namespace status {
   // return true iff t is a caterpillar
   bool detect_caterpillar(const tree& t);
 
+  // recognize a caterpillar and compute its encoding: the backbone (the path of non-leaf vertices, from one end to the
+  // other) as vertex numbers and the number of leaves hanging off each backbone vertex; backbone and leaves need room for
+  // t.get_size() entries, the length of the backbone is returned (or NOT_A_CATERPILLAR)
+  // the tree is walked down along the backbone once, nothing is allocated and nothing recurses
+  uint recognize_caterpillar(const tree& t, uint* const backbone, uint* const leaves);
+  // build the caterpillar with the given encoding (see recognize_caterpillar), rooted at the first backbone vertex
+  tree* caterpillar_from_leaves(const uint* const leaves, const uint length);
+
+#define NOT_A_CATERPILLAR UINT_MAX
+
 };
 
 
@@ -0,0 +1,103 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include "defs.hpp"
+#include <stdint.h>
+#include <vector>
+#include <thread>
+
+using namespace std;
+
+namespace status {
+
+  // the finalizer of splitmix64, a bijective scrambling of 64 bits
+  inline uint64_t mix64(uint64_t z){
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+  // splitmix64, used to expand a seed into a full state
+  inline uint64_t splitmix64(uint64_t& x){
+    return mix64(x += 0x9e3779b97f4a7c15ULL);
+  }
+
+  // xoshiro256** by Blackman & Vigna: 4 words of state, a handful of instructions per number
+  // it is a UniformRandomBitGenerator, so it can be used with std::shuffle & co
+  class rng {
+    uint64_t s[4];
+
+    static inline uint64_t rotl(const uint64_t x, const int k){ return (x << k) | (x >> (64 - k)); }
+  public:
+    typedef uint64_t result_type;
+
+    // the same seed and stream always give the same numbers; different streams of the same seed are independent
+    explicit rng(const uint64_t seed = 0, const uint64_t stream = 0){
+      uint64_t x(seed);
+      x = splitmix64(x) ^ mix64(stream + 1);
+      for(uint i = 0; i < 4; ++i) s[i] = splitmix64(x);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    inline result_type operator()(){
+      const uint64_t result(rotl(s[1] * 5, 7) * 9);
+      const uint64_t t(s[1] << 17);
+      s[2] ^= s[0];
+      s[3] ^= s[1];
+      s[1] ^= s[2];
+      s[0] ^= s[3];
+      s[2] ^= t;
+      s[3] = rotl(s[3], 45);
+      return result;
+    }
+
+    // uniform number in [0, bound) without modulo bias, using Lemire's multiply-and-shift (bound > 0)
+    inline uint64_t below(const uint64_t bound){
+      __uint128_t m((__uint128_t)(*this)() * bound);
+      uint64_t low((uint64_t)m);
+      if(low < bound){
+        const uint64_t threshold((-bound) % bound);
+        while(low < threshold){
+          m = (__uint128_t)(*this)() * bound;
+          low = (uint64_t)m;
+        }
+      }
+      return (uint64_t)(m >> 64);
+    }
+
+    // uniform number in [0,1)
+    inline double uniform01(){ return ((*this)() >> 11) * (1.0 / (1ULL << 53)); }
+  };
+
+  // the number of items that are drawn from the same stream in parallel_draw
+  const size_t random_chunk_size(1 << 16);
+
+  // call f(begin, end, r) for consecutive chunks of [begin_item, end_item) on all cores,
+  // where chunk k (covering items from k * random_chunk_size on) draws from stream k of the seed,
+  // so the outcome does not depend on the number of threads nor on how the range is split into calls
+  template<class F>
+  void parallel_draw(const size_t begin_item, const size_t end_item, const uint64_t seed, F f){
+    assert(begin_item % random_chunk_size == 0);
+    const size_t first_chunk(begin_item / random_chunk_size);
+    const size_t num_chunks((end_item + random_chunk_size - 1) / random_chunk_size - first_chunk);
+    const size_t num_threads(min<size_t>(max(thread::hardware_concurrency(), 1U), num_chunks));
+    // thread t does chunks t, t + num_threads, ...
+    auto work = [&](const size_t t){
+      for(size_t k = first_chunk + t; k < first_chunk + num_chunks; k += num_threads){
+        rng r(seed, k);
+        f(k * random_chunk_size, min(end_item, (k + 1) * random_chunk_size), r);
+      }
+    };
+    if(num_threads <= 1) { if(num_chunks) work(0); return; }
+    vector<thread> threads;
+    for(size_t t = 1; t < num_threads; ++t) threads.push_back(thread(work, t));
+    work(0);
+    for(thread& th : threads) th.join();
+  }
+  template<class F>
+  inline void parallel_draw(const size_t num_items, const uint64_t seed, F f){ parallel_draw(0, num_items, seed, f); }
+
+};
+
+#endif
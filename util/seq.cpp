@@ -1,107 +1,26 @@
 
 #include "seq.hpp"
+#include "flat.hpp"
+#include "tree_view.hpp"
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 namespace status {
 
-  struct status_helper {
-    uint paths_from_subtree;
-    uint paths_to_subtree;
-    uint subtree_size;
-    uint status;
-  };
-
-  // compute the subtree sizes of each vertex in the subtree
-  void compute_subtree_sizes(vertex* const v){
-    assert(v != NULL);
-    assert(v->get_data() == NULL);
-    uint* const data((uint*)calloc(1, sizeof(uint)));
-    const list<vertex*>& children(v->get_children());
-
-    // recurse for all children u of v
-    for(auto u = children.begin(); u != children.end(); ++u){
-      // compute the values for u
-      compute_subtree_sizes(*u);
-      // and use them to update v's data
-      *data += *((uint*)(*u)->get_data());
-    }
-    // add myself to the subtree_size
-    ++(*data);
-    v->set_data(data);
-  }
-
-
-
-
-  // compute the sum of lengths of paths in v's subtree going to v and write it to v's data (and return it)
-  void compute_paths_from_subtree(vertex* const v){
-    assert(v != NULL);
-    assert(v->get_data() == NULL);
-    status_helper* const data((status_helper*)calloc(1, sizeof(status_helper)));
-    const list<vertex*>& children(v->get_children());
-
-    // recurse for all children u of v
-    for(auto u = children.begin(); u != children.end(); ++u){
-      // compute the values for u
-      compute_paths_from_subtree(*u);
-      status_helper* const u_data((status_helper*)(*u)->get_data());
-      // and use them to update v's data
-      data->subtree_size += u_data->subtree_size;
-      // each path in the subtree of u is one longer in the subtree of v
-      data->paths_from_subtree += u_data->paths_from_subtree + u_data->subtree_size;
-    }
-    // add myself to the subtree_size
-    data->subtree_size++;
-
-    v->set_data(data);
-  }
-
-  // compute the sum of lengths of paths outside v's subtree going to v, add it to v's data (and return it)
-  void compute_paths_to_subtree(vertex* const v, const uint tree_size){
-    assert(v != NULL);
-    status_helper* data((status_helper*)(v->get_data()));
-    const list<vertex*>& children(v->get_children());
-    // set the status of v to the total incoming paths of v
-    data->status = data->paths_from_subtree + data->paths_to_subtree;
-
-    // recurse for all children u of v
-    for(auto u = children.begin(); u != children.end(); ++u){
-      status_helper* const u_data((status_helper*)(*u)->get_data());
-      // the size of paths to the subtree of u is computed from 3 parts: it is
-      //    1. the status of v
-      //    2. minus the paths from the subtree of u to v
-      //    3. plus one for each path to v that is not in the subtree of u
-      u_data->paths_to_subtree = data->status
-                                - ( u_data->paths_from_subtree + u_data->subtree_size )
-                                + ( tree_size - u_data->subtree_size );
-
-      // recurse for u
-      compute_paths_to_subtree(*u, tree_size);
-    }
-  }
-  // read the previously computed stati
-  void read_status_sequence(const vertex* const v, sequence_t& seq){
-    assert(v != NULL);
-    const list<vertex*>& children(v->get_children());
-
-    seq[((status_helper*)(v->get_data()))->status]++;
-    // recurse for all children u of v
-    for(auto u = children.begin(); u != children.end(); ++u)
-      read_status_sequence(*u, seq);
+  void compute_stati(const tree& t, uint* const status){
+    compute_stati(pointer_tree_view(t), status);
   }
 
   sequence_t compute_stati(const tree& t){
+    stati_result r;
+    compute_stati<HISTOGRAM>(pointer_tree_view(t), r);
     sequence_t seq;
-    if(! t.get_size()) return seq;
-
-    // prepare the tree
-    vertex* const root = t.get_root();
-    DEBUG1(cout << "step1: paths from subtrees"<<endl);
-    compute_paths_from_subtree(root);
-    DEBUG1(cout << "step2: paths to subtrees"<<endl);
-    compute_paths_to_subtree(root, t.get_size());
-    DEBUG1(cout << "step3: stati"<<endl);
-    read_status_sequence(root, seq);
-
+    seq.swap(r.histogram);
     return seq;
   }
 
@@ -124,57 +43,200 @@ namespace status {
 
   // return the number of vertices implied by the status sequence_t
   uint get_num_vertices(const sequence_t& s){
-    uint result = 0;
+    uint64_t result = 0;
     for(auto i = s.begin(); i != s.end(); ++i)
       result += i->second;
+    if(result > UINT_MAX) FAIL("the sequence has "<<result<<" vertices, more than we can count");
     return result;
   }
 
-  // read a sequence_t from file
+  // ====================== sequence files =============================
+
   sequence_t read_sequence_from_file(const string filename){
-    ifstream f(filename);
-    if(f.bad()) FAIL("unable to open "<<filename<<" for reading");
-    
+    sequence_reader r(filename);
     sequence_t s;
-    
+    if(r.next(s) == LINE_MALFORMED) FAIL(filename<<":"<<r.get_line_number()<<": "<<r.get_error());
+    return s;
+  }
+
+  void write_sequence_to_file(const sequence_t& s, const string filename){
+    sequence_writer w(filename);
+    w.write(s);
+  }
+
+  sequence_reader::sequence_reader(const string filename):
+    data(NULL), bytes(0), pos(NULL), line_number(0), error(NULL)
+  {
+    const int fd(open(filename.c_str(), O_RDONLY));
+    if(fd < 0) FAIL("unable to open "<<filename<<" for reading");
+    struct stat st;
+    if(fstat(fd, &st)) FAIL("unable to stat "<<filename);
+    if(!S_ISREG(st.st_mode)){
+      // the size of a pipe is not known in advance, so we read until the end into a growing buffer
+      contents.resize(1 << 16);
+      while(true){
+        if(bytes == contents.size()) contents.resize(2 * contents.size());
+        const ssize_t r(read(fd, contents.data() + bytes, contents.size() - bytes));
+        if(r < 0){
+          if(errno == EINTR) continue;
+          FAIL("unable to read "<<filename);
+        }
+        if(!r) break;
+        bytes += r;
+      }
+      data = contents.data();
+    } else if((bytes = st.st_size)){
+      void* const m(mmap(NULL, bytes, PROT_READ, MAP_PRIVATE, fd, 0));
+      if(m == MAP_FAILED) FAIL("unable to map "<<filename);
+      madvise(m, bytes, MADV_SEQUENTIAL);
+      data = (const char*)m;
+    }
+    close(fd);
+    pos = data;
+  }
+
+  sequence_reader::~sequence_reader(){
+    if(bytes && contents.empty()) munmap((void*)data, bytes);
+  }
+
+  // the characters separating the entries of a line
+  inline bool is_blank(const char c){ return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\b'); }
+
+  // parse the number at p (before end) into x and move p behind it, return false if there is none or it is too large
+  inline bool parse_uint(const char*& p, const char* const end, uint& x){
+    const char* const first(p);
+    uint64_t result = 0;
+    for(; (p < end) && ((unsigned char)(*p - '0') < 10); ++p)
+      if((result = 10 * result + (*p - '0')) > UINT_MAX) return false;
+    x = result;
+    return p != first;
+  }
+
+  line_result parse_sequence_line(const char* p, const char* const end, sequence_entries_t& entries, const char*& error){
+    entries.clear();
     while(true){
-      // read the next sequence
-      string s_list;
-      getline(f, s_list);
-      if(f.eof()) break;
-
-      list<string> items;
-
-      // split by space (separating 1x38 and 5x32)
-      split_no_empty(s_list, items);
-      for(string i : items){
-        list<string> components;
-        // split by x (separating 1 and 38)
-        split_no_empty(i, components, "x");
-        // register in the sequence
-        s[atoi(components.back().c_str())] = atoi(components.front().c_str());
+      while((p < end) && is_blank(*p)) ++p;
+      if(p == end) break;
+      uint multiplicity, status;
+      if(!parse_uint(p, end, multiplicity)) error = "expected a multiplicity (below 2^32)";
+      else if((p == end) || (*p++ != 'x')) error = "expected 'x' after the multiplicity";
+      else if(!multiplicity) error = "multiplicity 0";
+      else if(!parse_uint(p, end, status)) error = "expected a status (below 2^32) after 'x'";
+      else if((p < end) && !is_blank(*p)) error = "expected a blank after the status";
+      else {
+        entries.push_back(make_pair(status, multiplicity));
+        continue;
       }
+      return LINE_MALFORMED;
     }
-    return s;
+    error = NULL;
+    return entries.empty() ? LINE_EMPTY : LINE_SEQUENCE;
   }
 
-  void write_sequence_to_file(const sequence_t& s, const string filename){
-    ofstream f(filename);
-    if(f.bad()) FAIL("unable to open "<<filename<<" for writing");
-    f << s;
-  }
-
-  // compute one of the (at most two) vertices of minimum status
-  vertex* compute_median_subtree(vertex* const v){
-    const list<vertex*>& children(v->get_children());
-    vertex* min_status = v;
-    for(auto u = children.begin(); u != children.end(); ++u){
-      vertex* tmp = compute_median_subtree(*u);
-      // update min_status if the minimum status vertex in the subtree of u is smaller than the current min_status
-      if(((status_helper*)tmp->get_data())->status < ((status_helper*)min_status->get_data())->status)
-        min_status = tmp;
+  line_result sequence_reader::next(sequence_entries_t& entries){
+    const char* const end(data + bytes);
+    while(pos < end){
+      ++line_number;
+      const char* const newline((const char*)memchr(pos, '\n', end - pos));
+      const char* const line_end(newline ? newline : end);
+      const char* const line(pos);
+      pos = newline ? newline + 1 : end;
+      const line_result result(parse_sequence_line(line, line_end, entries, error));
+      if(result != LINE_EMPTY) return result;
+    }
+    entries.clear();
+    return LINE_END;
+  }
+
+  line_result sequence_reader::next(sequence_t& s){
+    s.clear();
+    const line_result result(next(scratch));
+    for(const auto& entry : scratch) s[entry.first] += entry.second;
+    return result;
+  }
+
+  const size_t sequence_buffer_size(1 << 20);
+
+  sequence_writer::sequence_writer(const string filename):
+    f(fopen(filename.c_str(), "wb")), buffer(sequence_buffer_size + 32), used(0)
+  {
+    if(!f) FAIL("unable to open "<<filename<<" for writing");
+  }
+
+  sequence_writer::~sequence_writer(){
+    flush();
+    fclose(f);
+  }
+
+  void sequence_writer::flush(){
+    if(used && (fwrite(buffer.data(), 1, used, f) != used)) FAIL("could not write sequence");
+    used = 0;
+  }
+
+  // an entry takes at most 22 characters, so the buffer has room for it unless it is full
+  inline void sequence_writer::put(const uint status, const uint multiplicity, const bool first){
+    if(!first) buffer[used++] = ' ';
+    used = print_uint(buffer.data(), used, multiplicity);
+    buffer[used++] = 'x';
+    used = print_uint(buffer.data(), used, status);
+    if(used >= sequence_buffer_size) flush();
+  }
+
+  inline void sequence_writer::end_line(){
+    buffer[used++] = '\n';
+    if(used >= sequence_buffer_size) flush();
+  }
+
+  void sequence_writer::write(const sequence_entries_t& entries){
+    for(size_t i = 0; i < entries.size(); ++i) put(entries[i].first, entries[i].second, i == 0);
+    end_line();
+  }
+
+  void sequence_writer::write(const sequence_t& s){
+    bool first(true);
+    for(const auto& entry : s){
+      put(entry.first, entry.second, first);
+      first = false;
+    }
+    end_line();
+  }
+
+  vertex* compute_median(const tree& t, const uint* const status){
+    if(t.empty()) return NULL;
+    uint min_status = 0;
+    for(uint i = 1; i < t.get_size(); ++i) if(status[i] < status[min_status]) min_status = i;
+    return t.get_vertex(min_status);
+  }
+
+  vertex* compute_centroid(const tree& t){
+    if(t.empty()) return NULL;
+    // BFS, the children of order[i] are order[first_child[i]...first_child[i+1]-1]
+    vector<vertex*> order(1, t.get_root());
+    vector<uint> first_child;
+    order.reserve(t.get_size());
+    first_child.reserve(t.get_size() + 1);
+    for(size_t i = 0; i < order.size(); ++i){
+      first_child.push_back(order.size());
+      for(vertex* c : order[i]->get_children()) order.push_back(c);
+    }
+    first_child.push_back(order.size());
+    // the subtree sizes bottom-up
+    vector<uint> size(order.size(), 1);
+    for(size_t i = order.size(); i-- > 0;)
+      for(uint j = first_child[i]; j < first_child[i + 1]; ++j) size[i] += size[j];
+    // walk down into the heavy child
+    const uint n(order.size());
+    uint v = 0;
+    while(true){
+      uint heavy = v;
+      for(uint j = first_child[v]; j < first_child[v + 1]; ++j)
+        if(2 * size[j] > n){
+          heavy = j;
+          break;
+        }
+      if(heavy == v) return order[v];
+      v = heavy;
     }
-    return min_status;
   }
 
   // compare two sequences
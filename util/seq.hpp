@@ -3,6 +3,8 @@
 
 #include "defs.hpp"
 #include "graphs.hpp"
+#include <stdio.h>
+#include <vector>
 #include <unordered_map>
 #include <unordered_set>
 #include <list>
@@ -14,8 +16,11 @@ namespace status {
   typedef list<uint> status_list_t;
   typedef unordered_set<uint> status_set_t;
 
-  // compute the status of each vertex
+  // compute the status sequence
   sequence_t compute_stati(const tree& t);
+  // write the status of each vertex v to status[v->get_id()] (status has room for t.get_size() numbers); both are the
+  // status kernel (see tree_view.hpp) on a pointer_tree_view, which computes more than the stati if asked
+  void compute_stati(const tree& t, uint* const status);
 
   // convert a status_sequence_t to a status_list
   list<uint> seq_to_list(const sequence_t& s);
@@ -23,16 +28,79 @@ namespace status {
   // return a list of stati occuring in the sequence_t
   list<uint> get_occuring_stati(const sequence_t& s);
 
-  // return the number of vertices implied by the status sequence_t
+  // return the number of vertices implied by the status sequence_t (failing if there are 2^32 or more, see
+  // prefilter_sequence for a check that does not fail)
   uint get_num_vertices(const sequence_t& s);
 
-  // read a sequence_t from file
+  // a sequence file holds one sequence per line, as "multiplicity x status" separated by blanks ("1x38 5x32 ...")
+  // read the first sequence of a sequence file (failing if it is malformed), and write a sequence file of one sequence
   sequence_t read_sequence_from_file(const string filename);
   void write_sequence_to_file(const sequence_t& s, const string filename);
 
-  // compute one of the (at most two) vertices of minimum status
-  vertex* compute_median_subtree(vertex* const v);
-  inline vertex* compute_median(const tree& t){ return compute_median_subtree(t.get_root()); }
+  // a sequence as (status, number of occurances) pairs, in the order in which they were read
+  typedef vector<pair<uint, uint> > sequence_entries_t;
+
+  // what we found in a line of a sequence file
+  enum line_result { LINE_SEQUENCE, LINE_MALFORMED, LINE_END, LINE_EMPTY };
+
+  // parse the line from p to end (without its newline) into entries and return LINE_SEQUENCE, or return LINE_EMPTY if it
+  // has nothing but blanks, or LINE_MALFORMED and what is wrong with it in error
+  line_result parse_sequence_line(const char* p, const char* const end, sequence_entries_t& entries, const char*& error);
+
+  // read the sequences of a sequence file one by one: the file is mapped into memory and parsed in place without going
+  // through streams or strings, so nothing is allocated once the entries have room for the longest sequence;
+  // empty lines are skipped, and so is a backspace at the end of a line (which we used to write)
+  // what cannot be mapped (pipes, FIFOs, terminals) is read into memory as a whole before parsing
+  class sequence_reader {
+    const char* data;
+    size_t bytes;
+    // the contents of a file that is not mapped
+    vector<char> contents;
+    // the beginning of the next line
+    const char* pos;
+    size_t line_number;
+    const char* error;
+    sequence_entries_t scratch;
+  public:
+    sequence_reader(const string filename);
+    ~sequence_reader();
+
+    // parse the next sequence into entries and return LINE_SEQUENCE, or return LINE_MALFORMED if the line is not a
+    // sequence (see get_error, the next call continues with the line after), or LINE_END at the end of the file;
+    // the lines are parsed by parse_sequence_line
+    line_result next(sequence_entries_t& entries);
+    // the same into a sequence_t, adding up the occurances of stati that appear more than once in the line
+    line_result next(sequence_t& s);
+
+    // the number of the line read last (counting from 1) and what is wrong with it if it is malformed
+    inline size_t get_line_number() const { return line_number; }
+    inline const char* get_error() const { return error; }
+  };
+
+  // write sequences to a sequence file, one per line, formatting the numbers into our own buffer
+  class sequence_writer {
+    FILE* f;
+    vector<char> buffer;
+    size_t used;
+
+    void flush();
+    // format an entry (after a blank unless it is the first of its line) and the end of a line into the buffer
+    inline void put(const uint status, const uint multiplicity, const bool first);
+    inline void end_line();
+  public:
+    sequence_writer(const string filename);
+    ~sequence_writer();
+
+    // write a sequence as one line, its entries in the order in which we get them
+    void write(const sequence_entries_t& entries);
+    void write(const sequence_t& s);
+  };
+
+  // compute one of the (at most two) vertices of minimum status, given the stati by vertex number
+  vertex* compute_median(const tree& t, const uint* const status);
+  // compute a vertex of minimum status without any stati: the median is the centroid, so we walk down from the root
+  // into the child whose subtree has more than half of the vertices for as long as there is one
+  vertex* compute_centroid(const tree& t);
 
   // compare two sequence_ts
   bool equal(const sequence_t& s1, const sequence_t& s2);
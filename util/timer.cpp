@@ -0,0 +1,175 @@
+#include "timer.hpp"
+#include <iomanip>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace status {
+
+  // the recorded phases, the counters and whether we record at all
+  list<phase_record> timings;
+  hw_counters* counters(NULL);
+  bool timing_on(false);
+
+  const char* const hw_event_names[HW_NUM_EVENTS] = { "cycles", "instructions", "cache_misses", "branch_misses" };
+
+  hw_counters::hw_counters(){
+    for(uint i = 0; i < HW_NUM_EVENTS; ++i) fds[i] = -1;
+#ifdef __linux__
+    const uint64_t configs[HW_NUM_EVENTS] = {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES
+    };
+    for(uint i = 0; i < HW_NUM_EVENTS; ++i){
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = configs[i];
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      // count this thread on any cpu; the first counter leads the group so that all of them run together
+      fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, (i ? fds[0] : -1), 0);
+      // if we cannot have all of them, we take none of them
+      if(fds[i] < 0){
+        for(uint j = 0; j < i; ++j) { close(fds[j]); fds[j] = -1; }
+        return;
+      }
+    }
+#endif
+  }
+
+  hw_counters::~hw_counters(){
+#ifdef __linux__
+    for(uint i = 0; i < HW_NUM_EVENTS; ++i) if(fds[i] >= 0) close(fds[i]);
+#endif
+  }
+
+  void hw_counters::read(uint64_t* values) const{
+    for(uint i = 0; i < HW_NUM_EVENTS; ++i){
+      values[i] = 0;
+#ifdef __linux__
+      if(fds[i] >= 0)
+        if(::read(fds[i], &values[i], sizeof(uint64_t)) != sizeof(uint64_t)) values[i] = 0;
+#endif
+    }
+  }
+
+  void enable_timing(const bool with_hw_counters){
+    timing_on = true;
+    if(with_hw_counters && !counters){
+      counters = new hw_counters();
+      if(!counters->available()){
+        cerr << "could not open hardware counters (check /proc/sys/kernel/perf_event_paranoid), timing only" << endl;
+        delete counters;
+        counters = NULL;
+      }
+    }
+  }
+  bool timing_enabled() { return timing_on; }
+  bool hw_counters_enabled() { return counters != NULL; }
+
+  // find the record of the given phase or create it
+  phase_record* get_record(const char* phase_name){
+    for(phase_record& r : timings)
+      if(r.name == phase_name) return &r;
+    timings.push_back(phase_record());
+    phase_record& r(timings.back());
+    r.name = phase_name;
+    r.calls = 0;
+    r.seconds = 0;
+    for(uint i = 0; i < HW_NUM_EVENTS; ++i) r.events[i] = 0;
+    return &r;
+  }
+
+  phase_timer::phase_timer(const char* phase_name):record(NULL){
+    if(!timing_on) return;
+    record = get_record(phase_name);
+    if(counters) counters->read(start_events);
+    // take the time last, so the bookkeeping does not end up in the measurement
+    start = chrono::steady_clock::now();
+  }
+
+  phase_timer::~phase_timer(){
+    if(!record) return;
+    const chrono::steady_clock::time_point end(chrono::steady_clock::now());
+    if(counters){
+      uint64_t end_events[HW_NUM_EVENTS];
+      counters->read(end_events);
+      for(uint i = 0; i < HW_NUM_EVENTS; ++i) record->events[i] += end_events[i] - start_events[i];
+    }
+    record->seconds += chrono::duration<double>(end - start).count();
+    record->calls++;
+  }
+
+  const list<phase_record>& get_timings(){ return timings; }
+
+  void print_timings(ostream& os, const bool machine_readable){
+    if(machine_readable){
+      os << "phase,calls,seconds";
+      if(counters) for(uint i = 0; i < HW_NUM_EVENTS; ++i) os << ',' << hw_event_names[i];
+      os << endl;
+      for(const phase_record& r : timings){
+        os << r.name << ',' << r.calls << ',' << setprecision(9) << r.seconds;
+        if(counters) for(uint i = 0; i < HW_NUM_EVENTS; ++i) os << ',' << r.events[i];
+        os << endl;
+      }
+    } else {
+      os << left << setw(24) << "phase" << right << setw(8) << "calls" << setw(14) << "seconds";
+      if(counters) for(uint i = 0; i < HW_NUM_EVENTS; ++i) os << setw(16) << hw_event_names[i];
+      if(counters) os << setw(8) << "IPC";
+      os << endl;
+      for(const phase_record& r : timings){
+        os << left << setw(24) << r.name << right << setw(8) << r.calls << setw(14) << fixed << setprecision(6) << r.seconds;
+        if(counters){
+          for(uint i = 0; i < HW_NUM_EVENTS; ++i) os << setw(16) << r.events[i];
+          os << setw(8) << setprecision(2) << (r.events[HW_CYCLES] ? (double)r.events[HW_INSTRUCTIONS] / r.events[HW_CYCLES] : 0.0);
+        }
+        os << endl;
+      }
+      os.unsetf(ios_base::floatfield);
+    }
+  }
+
+  // bucket of a latency: small ones get their own bucket, the others are bucketed by their highest 5 bits
+  inline uint latency_bucket(const uint64_t x){
+    if(x < 16) return x;
+    const uint e(63 - __builtin_clzll(x));
+    return (e - 3) * 16 + ((x >> (e - 4)) & 15);
+  }
+  // the smallest latency in a bucket
+  inline uint64_t bucket_latency(const uint b){
+    if(b < 16) return b;
+    return (uint64_t)(16 + (b & 15)) << (b / 16 - 1);
+  }
+
+  latency_histogram::latency_histogram(): count(latency_bucket(UINT64_MAX) + 1, 0), total(0) {}
+
+  void latency_histogram::add(const uint64_t nanoseconds){
+    ++count[latency_bucket(nanoseconds)];
+    ++total;
+  }
+
+  void latency_histogram::merge(const latency_histogram& h){
+    for(uint b = 0; b < count.size(); ++b) count[b] += h.count[b];
+    total += h.total;
+  }
+
+  uint64_t latency_histogram::percentile(const double fraction) const{
+    if(!total) return 0;
+    const uint64_t rank(fraction * (total - 1));
+    uint64_t seen = 0;
+    for(uint b = 0; b < count.size(); ++b){
+      seen += count[b];
+      if(seen > rank) return bucket_latency(b);
+    }
+    return bucket_latency(count.size() - 1);
+  }
+
+}
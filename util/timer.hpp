@@ -0,0 +1,74 @@
+#ifndef TIMER_HPP
+#define TIMER_HPP
+
+#include "defs.hpp"
+#include <chrono>
+#include <list>
+#include <string>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+namespace status {
+
+  // hardware events that can be counted alongside the wallclock time (needs Linux' perf_event_open)
+  enum hw_event { HW_CYCLES, HW_INSTRUCTIONS, HW_CACHE_MISSES, HW_BRANCH_MISSES, HW_NUM_EVENTS };
+
+  // accumulated measurements of a phase
+  struct phase_record {
+    string name;
+    uint calls;
+    double seconds;
+    uint64_t events[HW_NUM_EVENTS];
+  };
+
+  // a group of hardware counters of the calling thread that run from construction to destruction
+  class hw_counters {
+    int fds[HW_NUM_EVENTS];
+  public:
+    hw_counters();
+    ~hw_counters();
+    // return whether the kernel let us open the counters
+    inline bool available() const { return fds[0] >= 0; }
+    // read the current values of the counters (all 0 if not available)
+    void read(uint64_t* values) const;
+  };
+
+  // switch timing on (optionally with hardware counters); as long as it is off, phase_timers cost next to nothing
+  void enable_timing(const bool with_hw_counters = false);
+  bool timing_enabled();
+  bool hw_counters_enabled();
+
+  // measure the time (and hardware events) between construction and destruction and account it to the given phase;
+  // phases may be nested, in which case the inner phase is also accounted to the outer one
+  class phase_timer {
+    phase_record* record;
+    chrono::steady_clock::time_point start;
+    uint64_t start_events[HW_NUM_EVENTS];
+  public:
+    phase_timer(const char* phase_name);
+    ~phase_timer();
+  };
+
+  // return the phases in order of their first occurance
+  const list<phase_record>& get_timings();
+  // print the per-phase breakdown, either as table or as CSV
+  void print_timings(ostream& os, const bool machine_readable = false);
+
+  // count latencies (in nanoseconds) in logarithmic buckets, 16 per power of two, so percentiles are exact up to 1/16
+  // and a histogram has constant size, however long it runs
+  class latency_histogram {
+    vector<uint64_t> count;
+    uint64_t total;
+  public:
+    latency_histogram();
+    void add(const uint64_t nanoseconds);
+    void merge(const latency_histogram& h);
+    inline uint64_t size() const { return total; }
+    // the (lower end of the bucket of the) latency below which lie the given fraction of the latencies
+    uint64_t percentile(const double fraction) const;
+  };
+}
+
+#endif
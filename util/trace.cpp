@@ -0,0 +1,113 @@
+#include "trace.hpp"
+#include "tree_view.hpp"
+
+namespace status {
+
+  pair<uint, uint> trace_computer::compute_stati(const parent_array& parent){
+    stati.resize(parent.size());
+    status::compute_stati(parent_array_view(parent), stati.data());
+    uint min_status = UINT_MAX, max_status = 0;
+    for(const uint s : stati){
+      min_status = min(min_status, s);
+      max_status = max(max_status, s);
+    }
+    return make_pair(min_status, max_status);
+  }
+
+  void trace_computer::deduplicate(const uint min_status, const uint max_status, trace_t& result){
+    const uint n(stati.size());
+    const size_t range((size_t)max_status - min_status + 1);
+    if(range <= 4 * (size_t)n + 64){
+      // the stati are dense enough to mark them
+      seen.assign(range, false);
+      for(const uint s : stati) seen[s - min_status] = true;
+      for(size_t i = 0; i < range; ++i) if(seen[i]) result.push_back(min_status + i);
+    } else {
+      // LSD radix sort with 16 bit digits of the offsets from the minimum
+      sorted.resize(n);
+      sorted_tmp.resize(n);
+      for(uint v = 0; v < n; ++v) sorted[v] = stati[v] - min_status;
+      for(uint shift = 0; shift < 32; shift += 16){
+        if(((range - 1) >> shift) == 0) break;
+        count.assign((1 << 16) + 1, 0);
+        for(const uint s : sorted) ++count[((s >> shift) & 0xffff) + 1];
+        for(uint d = 0; d < (1 << 16); ++d) count[d + 1] += count[d];
+        for(const uint s : sorted) sorted_tmp[count[(s >> shift) & 0xffff]++] = s;
+        sorted.swap(sorted_tmp);
+      }
+      for(uint i = 0; i < n; ++i)
+        if(!i || (sorted[i] != sorted[i - 1])) result.push_back(min_status + sorted[i]);
+    }
+  }
+
+  void trace_computer::trace(const parent_array& parent, trace_t& result){
+    result.clear();
+    if(parent.empty()) return;
+    const pair<uint, uint> bounds(compute_stati(parent));
+    deduplicate(bounds.first, bounds.second, result);
+  }
+
+  void trace_computer::traces(const vector<parent_array>& trees, vector<uint>& result, vector<size_t>& offset){
+    result.clear();
+    offset.assign(1, 0);
+    for(const parent_array& parent : trees){
+      if(!parent.empty()){
+        const pair<uint, uint> bounds(compute_stati(parent));
+        deduplicate(bounds.first, bounds.second, result);
+      }
+      offset.push_back(result.size());
+    }
+  }
+
+  void trace_computer::trace_tree(const parent_array& parent, parent_array& trace_parent, vector<trace_vertex>& trace_data){
+    trace_parent.clear();
+    trace_data.clear();
+    if(parent.empty()) return;
+    compute_stati(parent);
+    // top-down, v joins the child of its parent's trace vertex that has v's status, if there is one
+    trie_child.clear();
+    trie_node.resize(parent.size());
+    trie_node[0] = 0;
+    trace_parent.push_back(NO_PARENT);
+    trace_data.push_back({stati[0], 1});
+    for(uint v = 1; v < parent.size(); ++v){
+      const uint64_t key(((uint64_t)trie_node[parent[v]] << 32) | stati[v]);
+      const auto it(trie_child.insert(make_pair(key, (uint)trace_parent.size())));
+      if(it.second){
+        trace_parent.push_back(trie_node[parent[v]]);
+        trace_data.push_back({stati[v], 0});
+      }
+      trie_node[v] = it.first->second;
+      ++trace_data[trie_node[v]].multiplicity;
+    }
+  }
+
+  // ==================== pointer trees =========================
+
+  trace_t compute_trace(const tree& t){
+    parent_array parent;
+    trace_computer c;
+    trace_t result;
+    tree_to_parents(t, parent);
+    c.trace(parent, result);
+    return result;
+  }
+
+  tree* compute_tracetree(const tree& t){
+    parent_array parent, trace_parent;
+    vector<trace_vertex> trace_data;
+    trace_computer c;
+    tree_to_parents(t, parent);
+    c.trace_tree(parent, trace_parent, trace_data);
+
+    tree* result = new tree();
+    vector<vertex*> vertex_nr(trace_parent.size());
+    for(uint i = 0; i < trace_parent.size(); ++i){
+      trace_vertex* const data((trace_vertex*)malloc(sizeof(trace_vertex)));
+      *data = trace_data[i];
+      vertex_nr[i] = result->add_vertex(i ? vertex_nr[trace_parent[i]] : NULL, data);
+    }
+    return result;
+  }
+
+};
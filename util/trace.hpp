@@ -3,12 +3,56 @@
 
 #include "defs.hpp"
 #include "graphs.hpp"
+#include "flat.hpp"
+#include <vector>
+
+using namespace std;
 
 namespace status {
 
+  // the trace of a tree is the set of its distinct stati, we keep it as increasing vector
+  typedef vector<uint> trace_t;
+
+  // the trace tree of a rooted tree identifies two vertices iff they have the same status and their parents are identified,
+  // that is, it is the trie of the status sequences along the paths from the root;
+  // each vertex of the trace tree knows its status and how many vertices of the tree it stands for
+  struct trace_vertex {
+    uint status;
+    uint multiplicity;
+  };
+
+  // compute traces and trace trees of flat trees (in topological order), without going through sequence_t;
+  // the stati are computed by the status kernel (see tree_view.hpp) and deduplicated by marking them in a bitmap if they
+  // are close together (as they are in bushy trees) and by radix sort otherwise (as in long paths)
+  // all scratch space is kept between calls, so computing the traces of many trees does not allocate after a while
+  class trace_computer {
+    vector<uint> stati;
+    vector<uint> sorted, sorted_tmp;
+    vector<uint> count;
+    vector<bool> seen;
+    unordered_map<uint64_t, uint> trie_child;
+    vector<uint> trie_node;
+
+    // compute the stati of all vertices, return their minimum and maximum
+    pair<uint, uint> compute_stati(const parent_array& parent);
+    // deduplicate the stati into the trace
+    void deduplicate(const uint min_status, const uint max_status, trace_t& result);
+  public:
+    // compute the trace of the tree
+    void trace(const parent_array& parent, trace_t& result);
+    // compute the traces of many trees, the trace of trees[i] is result[offset[i]...offset[i+1]-1]
+    void traces(const vector<parent_array>& trees, vector<uint>& result, vector<size_t>& offset);
+    // compute the trace tree (rooted at the root of the tree, in topological order)
+    void trace_tree(const parent_array& parent, parent_array& trace_parent, vector<trace_vertex>& trace_data);
+
+    // return the status of each vertex after the last call
+    inline const vector<uint>& get_stati() const { return stati; }
+  };
 
-  tree compute_tracetree(const tree& t){
-  }
+  // convenience functions for pointer trees
+  trace_t compute_trace(const tree& t);
+  // compute the trace tree of t, the data of each vertex is a trace_vertex (freed by clear_data())
+  tree* compute_tracetree(const tree& t);
 
 };
 
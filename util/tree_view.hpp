@@ -0,0 +1,328 @@
+#ifndef TREE_VIEW_HPP
+#define TREE_VIEW_HPP
+
+#include "defs.hpp"
+#include "graphs.hpp"
+#include "flat.hpp"
+#include "seq.hpp"
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+namespace status {
+
+  // the templates below compute on any tree that offers the following (a "tree view"), so trees kept in other forms do
+  // not have to be converted to pointer trees first; the vertices of a view are numbered 0...size()-1
+  //   uint size() const               - the number of vertices
+  //   uint root() const               - the number of the root
+  //   uint parent(const uint v) const - the number of the parent of v, NO_PARENT for the root
+  //   R children(const uint v) const  - the numbers of the children of v, as anything with begin() and end()
+  //   static const bool topological   - true iff the root is 0 and each parent is smaller than its children
+  // the templates only sweep over the numbers and look at parents if the view is topological, and they only look at
+  // children otherwise, so each kind of view needs to offer only one of the two
+
+  // the numbers in an array, as range
+  class id_range {
+    const uint* first;
+    const uint* last;
+  public:
+    id_range(const uint* const _first, const uint* const _last): first(_first), last(_last) {}
+    inline const uint* begin() const { return first; }
+    inline const uint* end() const { return last; }
+  };
+
+  // a view of a flat tree in topological order (see flat.hpp), without children
+  class parent_array_view {
+    const uint* parents;
+    uint n;
+  public:
+    static const bool topological = true;
+
+    parent_array_view(const uint* const _parents, const uint _n): parents(_parents), n(_n) {}
+    parent_array_view(const parent_array& _parents): parents(_parents.data()), n(_parents.size()) {}
+
+    inline uint size() const { return n; }
+    inline uint root() const { return 0; }
+    inline uint parent(const uint v) const { return parents[v]; }
+  };
+
+  // a view of a tree whose children are kept in CSR: the children of v are child_list[first_child[v]...first_child[v+1]-1]
+  // (first_child has n+1 entries); the parents are optional (NULL), the templates do not need them for this view
+  class csr_tree_view {
+    const uint* first_child;
+    const uint* child_list;
+    const uint* parents;
+    uint n;
+    uint root_id;
+  public:
+    static const bool topological = false;
+
+    csr_tree_view(const uint* const _first_child, const uint* const _child_list, const uint _n, const uint _root = 0,
+                  const uint* const _parents = NULL):
+      first_child(_first_child), child_list(_child_list), parents(_parents), n(_n), root_id(_root) {}
+
+    inline uint size() const { return n; }
+    inline uint root() const { return root_id; }
+    inline uint parent(const uint v) const { assert(parents); return parents[v]; }
+    inline id_range children(const uint v) const { return id_range(child_list + first_child[v], child_list + first_child[v + 1]); }
+  };
+
+  // a view of a pointer tree, the number of a vertex is its ID (see tree::add_vertex)
+  class pointer_tree_view {
+    const tree& t;
+  public:
+    static const bool topological = false;
+
+    // the children of a vertex by number
+    class child_iterator {
+      list<vertex*>::const_iterator i;
+    public:
+      child_iterator(const list<vertex*>::const_iterator _i): i(_i) {}
+      inline uint operator*() const { return (*i)->get_id(); }
+      inline child_iterator& operator++() { ++i; return *this; }
+      inline bool operator==(const child_iterator& it) const { return i == it.i; }
+      inline bool operator!=(const child_iterator& it) const { return i != it.i; }
+    };
+    class child_range {
+      const list<vertex*>& children;
+    public:
+      child_range(const list<vertex*>& _children): children(_children) {}
+      inline child_iterator begin() const { return child_iterator(children.begin()); }
+      inline child_iterator end() const { return child_iterator(children.end()); }
+    };
+
+    pointer_tree_view(const tree& _t): t(_t) {}
+
+    inline uint size() const { return t.get_size(); }
+    inline uint root() const { return t.get_root()->get_id(); }
+    inline uint parent(const uint v) const {
+      const vertex* const p(t.get_vertex(v)->get_parent());
+      return p ? p->get_id() : NO_PARENT;
+    }
+    inline child_range children(const uint v) const { return child_range(t.get_vertex(v)->get_children()); }
+  };
+
+
+  // the invariants the status kernel can compute, combine them with |
+  enum stati_feature {
+    STATUS        = 1,  // status of each vertex
+    SUBTREE_SIZE  = 2,  // number of vertices in the subtree of each vertex
+    DEPTH         = 4,  // distance of each vertex to the root
+    ECCENTRICITY  = 8,  // distance of each vertex to the farthest vertex, and the center
+    WIENER_INDEX  = 16, // the sum of the distances of all pairs, that is, half the sum of the stati
+    HISTOGRAM     = 32  // the status sequence
+  };
+
+  // the results of the status kernel; per-vertex results are indexed by the number of the vertex in the view (the ID
+  // for pointer trees)
+  struct stati_result {
+    vector<uint> status;
+    vector<uint> subtree_size;
+    vector<uint> depth;
+    vector<uint> eccentricity;
+    // the (one or two) vertices of minimum eccentricity
+    vector<uint> center;
+    uint64_t wiener_index;
+    sequence_t histogram;
+
+    // scratch: the vertices in BFS order (for views that are not topological), the heights of the highest two subtrees
+    // of children, the child of the highest and the distance to the farthest vertex outside the subtree
+    vector<uint> order;
+    vector<uint> height1, height2, highest_child, up;
+  };
+
+  // the work of the status kernel on each edge from a vertex p to its child v and on each vertex once it is done
+  template<uint features>
+  struct stati_sweep {
+    static const bool need_status = features & (STATUS | WIENER_INDEX | HISTOGRAM);
+    static const bool need_size = features & (STATUS | SUBTREE_SIZE | WIENER_INDEX | HISTOGRAM);
+    static const bool need_height = features & ECCENTRICITY;
+    stati_result& r;
+    const uint n;
+    uint* const status;
+    // the subtree sizes, which share the memory of the stati unless both are wanted
+    uint* const size;
+    uint root_status;
+    uint radius;
+
+    stati_sweep(stati_result& _r, const uint _n, uint* const _status, uint* const _size):
+      r(_r), n(_n), status(_status), size(_size), root_status(0), radius(UINT_MAX) {}
+
+    // bottom-up: the subtree of v is done, the status of the root is the sum of the sizes of all other subtrees
+    inline void up(const uint p, const uint v){
+      if(need_size){
+        size[p] += size[v];
+        root_status += size[v];
+      }
+      if(need_height){
+        const uint h(r.height1[v] + 1);
+        if(h > r.height1[p]){
+          r.height2[p] = r.height1[p];
+          r.height1[p] = h;
+          r.highest_child[p] = v;
+        } else if(h > r.height2[p]) r.height2[p] = h;
+      }
+    }
+    inline void root(const uint v){
+      if(need_status) status[v] = root_status;
+      if(features & DEPTH) r.depth[v] = 0;
+      if(need_height) r.up[v] = 0;
+      done(v);
+    }
+    // top-down: moving from p to v brings the subtree of v closer and everything else further away; the farthest vertex
+    // outside the subtree of v is either outside the subtree of p or in another child's subtree (or p itself)
+    inline void down(const uint p, const uint v){
+      if(need_status) status[v] = status[p] + n - 2 * size[v];
+      if(features & DEPTH) r.depth[v] = r.depth[p] + 1;
+      if(need_height) r.up[v] = 1 + max(r.up[p], r.highest_child[p] == v ? r.height2[p] : r.height1[p]);
+      done(v);
+    }
+    inline void done(const uint v){
+      if(features & WIENER_INDEX) r.wiener_index += status[v];
+      if(features & HISTOGRAM) r.histogram[status[v]]++;
+      if(need_height){
+        const uint e(max(r.up[v], r.height1[v]));
+        r.eccentricity[v] = e;
+        if(e < radius){
+          radius = e;
+          r.center.clear();
+        }
+        if(e == radius) r.center.push_back(v);
+      }
+    }
+  };
+
+  // topological views: going through the vertices backwards and then forwards, nothing is allocated
+  template<uint features, class Tree>
+  void sweep_stati(const Tree& t, stati_sweep<features>& s, stati_result&, true_type){
+    const uint n(t.size());
+    for(uint v = n; --v > 0;) s.up(t.parent(v), v);
+    s.root(0);
+    for(uint v = 1; v < n; ++v) s.down(t.parent(v), v);
+  }
+  // other views: the same in BFS order
+  template<uint features, class Tree>
+  void sweep_stati(const Tree& t, stati_sweep<features>& s, stati_result& r, false_type){
+    vector<uint>& order(r.order);
+    order.clear();
+    order.reserve(t.size());
+    order.push_back(t.root());
+    for(size_t i = 0; i < order.size(); ++i)
+      for(const uint c : t.children(order[i])) order.push_back(c);
+    for(size_t i = order.size(); i-- > 0;)
+      for(const uint c : t.children(order[i])) s.up(order[i], c);
+    s.root(order[0]);
+    for(const uint v : order)
+      for(const uint c : t.children(v)) s.down(v, c);
+  }
+
+  // compute any subset of the invariants (given as compile-time features) in two sweeps over the tree, the subtree sizes
+  // and heights bottom-up and everything else top-down from the parents, writing the stati to status (which has room
+  // for t.size() numbers) instead of r.status; the result vectors are reused, so computing many trees with the same
+  // result does not allocate after a while
+  template<uint features, class Tree>
+  void compute_stati(const Tree& t, stati_result& r, uint* status){
+    const uint n(t.size());
+    r.center.clear();
+    r.histogram.clear();
+    r.wiener_index = 0;
+    if(!n) return;
+    uint* size(NULL);
+    if(features & SUBTREE_SIZE){
+      r.subtree_size.assign(n, 1);
+      size = r.subtree_size.data();
+    } else if(stati_sweep<features>::need_status){
+      fill(status, status + n, 1);
+      size = status;
+    }
+    if(features & DEPTH) r.depth.resize(n);
+    if(features & ECCENTRICITY){
+      r.height1.assign(n, 0);
+      r.height2.assign(n, 0);
+      r.highest_child.assign(n, UINT_MAX);
+      r.up.resize(n);
+      r.eccentricity.resize(n);
+    }
+    stati_sweep<features> s(r, n, status, size);
+    sweep_stati(t, s, r, integral_constant<bool, Tree::topological>());
+    if(features & WIENER_INDEX) r.wiener_index /= 2;
+  }
+  template<uint features, class Tree>
+  inline void compute_stati(const Tree& t, stati_result& r){
+    if(stati_sweep<features>::need_status) r.status.resize(t.size());
+    compute_stati<features>(t, r, r.status.data());
+  }
+
+  // write the status of each vertex v to status[v] (status has room for t.size() numbers), see compute_stati(tree)
+  template<class Tree>
+  inline void compute_stati(const Tree& t, uint* const status){
+    stati_result r;
+    compute_stati<STATUS>(t, r, status);
+  }
+
+  // return the number of a vertex of minimum status, given the stati by number (UINT_MAX if the tree is empty)
+  template<class Tree>
+  uint compute_median(const Tree& t, const uint* const status){
+    const uint n(t.size());
+    if(!n) return UINT_MAX;
+    uint min_status = 0;
+    for(uint v = 1; v < n; ++v) if(status[v] < status[min_status]) min_status = v;
+    return min_status;
+  }
+
+  // return true iff t is a caterpillar, that is, no vertex has more than two neighbors that are not leaves (see
+  // detect_caterpillar(tree)); the root is a leaf iff it has a single child, which may then have two non-leaf children
+  // topological views: going through the vertices backwards, each vertex tells its parent whether it has children, the
+  // number of non-leaf children of v is then kept in flags[v] / 2 and whether it has any children in flags[v] & 1
+  template<class Tree>
+  bool detect_caterpillar(const Tree& t, true_type){
+    const uint n(t.size());
+    if(n < 3) return true;
+    vector<uint> flags(n, 0);
+    uint root_children = 0, only_child = 0;
+    for(uint v = n; --v > 0;){
+      const uint p(t.parent(v));
+      if(flags[v] & 1) flags[p] += 2;
+      flags[p] |= 1;
+      if(!p){
+        ++root_children;
+        only_child = v;
+      }
+    }
+    const uint top(root_children == 1 ? only_child : 0);
+    for(uint v = 0; v < n; ++v)
+      if(flags[v] / 2 > (v == top ? 2U : 1U)) return false;
+    return true;
+  }
+  // other views: count the non-leaf children of each vertex, nothing is allocated
+  template<class Tree>
+  bool detect_caterpillar(const Tree& t, false_type){
+    const uint n(t.size());
+    if(n < 3) return true;
+    uint top(t.root());
+    {
+      const auto root_children(t.children(top));
+      auto i(root_children.begin());
+      const uint first(*i);
+      if(++i == root_children.end()) top = first;
+    }
+    for(uint v = 0; v < n; ++v){
+      uint non_leaf_children = 0;
+      for(const uint c : t.children(v)){
+        const auto grandchildren(t.children(c));
+        if(grandchildren.begin() != grandchildren.end()) ++non_leaf_children;
+      }
+      if(non_leaf_children > (v == top ? 2U : 1U)) return false;
+    }
+    return true;
+  }
+  template<class Tree>
+  inline bool detect_caterpillar(const Tree& t){
+    return detect_caterpillar(t, integral_constant<bool, Tree::topological>());
+  }
+
+};
+
+#endif